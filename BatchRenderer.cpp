@@ -0,0 +1,84 @@
+#include "BatchRenderer.hpp"
+
+
+BatchRenderer::BatchRenderer(const unsigned worker_count) {
+    for (unsigned i = 0; i < std::max(worker_count, 1u); ++i) {
+        _workers.emplace_back(&BatchRenderer::work, this);
+    }
+}
+
+BatchRenderer::~BatchRenderer() {
+    {
+        std::lock_guard lock(_mutex);
+        _stopping = true;
+    }
+    _job_queued.notify_all();
+    for (auto& worker : _workers) {
+        worker.join();
+    }
+}
+
+std::future<RenderedImage> BatchRenderer::submit(RenderRequest request) {
+    std::future<RenderedImage> image;
+    {
+        std::lock_guard lock(_mutex);
+        auto& job = _queue.emplace_back(Job{ std::move(request), {} });
+        image = job.image.get_future();
+    }
+    _job_queued.notify_one();
+    return image;
+}
+
+std::vector<RenderedImage> BatchRenderer::render(const std::span<const RenderRequest> requests) {
+    std::vector<std::future<RenderedImage>> futures;
+    futures.reserve(requests.size());
+    for (const auto& request : requests) {
+        futures.push_back(submit(request));
+    }
+    std::vector<RenderedImage> images;
+    images.reserve(futures.size());
+    for (auto& future : futures) {
+        images.push_back(future.get());
+    }
+    return images;
+}
+
+RenderedImage BatchRenderer::render_now(const RenderRequest& request) {
+    Engine3D context(request.width, request.height, "Batch", Renderer::Display::Headless);
+    // Requests already run one per core, so each keeps its frame on its own thread
+    JobSystem::Options jobs;
+    jobs.worker_count = 0;
+    context.configure_jobs(jobs);
+    context.set_sample_count(request.sample_count);
+    context.set_drawing_mode(request.drawing_mode);
+    context.set_camera(request.camera_position, request.camera_direction, request.field_of_view);
+    context.set_mesh(MeshLoader::load_now(request.mesh, request.mesh_options));
+    context.set_frame_limit(1);
+    context.run();
+
+    RenderedImage image = { context.width(), context.height(), {} };
+    image.pixels.resize(static_cast<size_t>(image.width) * image.height);
+    context.capture(image.pixels);
+    return image;
+}
+
+void BatchRenderer::work() {
+    while (true) {
+        Job job;
+        {
+            std::unique_lock lock(_mutex);
+            _job_queued.wait(lock, [this] { return _stopping or not _queue.empty(); });
+            if (_queue.empty()) {
+                return;
+            }
+            job = std::move(_queue.front());
+            _queue.pop_front();
+        }
+
+        try {
+            job.image.set_value(render_now(job.request));
+        } catch (...) {
+            job.image.set_exception(std::current_exception());
+        }
+    }
+}
@@ -0,0 +1,67 @@
+#pragma once
+
+#include "Engine3D.hpp"
+
+#include <condition_variable>
+#include <deque>
+#include <future>
+#include <mutex>
+#include <span>
+#include <string>
+#include <thread>
+#include <vector>
+
+
+// One image for BatchRenderer: a mesh, placed at the scene centre, seen from a camera at a resolution
+struct RenderRequest {
+    std::string mesh;
+    MeshLoadOptions mesh_options;
+    Vector3D camera_position = { 0, 2, 10 };
+    Vector3D camera_direction = { 0, 0, 1 };
+    Scalar field_of_view = 90;
+    int width = 256;
+    int height = 256;
+    int sample_count = 1;
+    Engine3D::DrawingMode drawing_mode = Engine3D::DrawingMode::Filled;
+};
+
+struct RenderedImage {
+    int width = 0;
+    int height = 0;
+    // Row by row from the top left
+    std::vector<Pixel> pixels;
+};
+
+
+// Renders queued requests concurrently. Each worker draws one request at a time in a headless Engine3D
+// of its own, parsing the mesh and running the frame on its own thread, so requests share no state and
+// throughput follows the worker count
+class BatchRenderer {
+public:
+    explicit BatchRenderer(unsigned worker_count = std::max(std::thread::hardware_concurrency(), 1u));
+    // Finishes every queued request first
+    ~BatchRenderer();
+    BatchRenderer(const BatchRenderer&) = delete;
+    BatchRenderer& operator=(const BatchRenderer&) = delete;
+
+    // The future rethrows whatever the render threw, such as a mesh that failed to load
+    std::future<RenderedImage> submit(RenderRequest);
+    // Queues every request and waits for all of them; the images are in request order
+    std::vector<RenderedImage> render(std::span<const RenderRequest>);
+
+    // Renders one request on the calling thread
+    static RenderedImage render_now(const RenderRequest&);
+private:
+    struct Job {
+        RenderRequest request;
+        std::promise<RenderedImage> image;
+    };
+
+    void work();
+
+    std::deque<Job> _queue;
+    bool _stopping = false;
+    std::mutex _mutex;
+    std::condition_variable _job_queued;
+    std::vector<std::thread> _workers;
+};
@@ -0,0 +1,103 @@
+#include "CpuFeatures.hpp"
+
+#include <cstdlib>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+
+#if defined(RENDERER_X86) and defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+
+namespace {
+    InstructionSet detect() {
+#if defined(RENDERER_X86) and defined(_MSC_VER)
+        int info[4];
+        __cpuid(info, 0);
+        const int highest_leaf = info[0];
+        __cpuid(info, 1);
+        if (not (info[3] & 1 << 26)) {
+            return InstructionSet::Scalar;
+        }
+        // Wider registers are only usable once the operating system saves them on a context switch
+        const bool os_saves_state = info[2] & 1 << 27;
+        const bool avx = info[2] & 1 << 28;
+        if (not os_saves_state or not avx or highest_leaf < 7) {
+            return InstructionSet::SSE2;
+        }
+        const unsigned long long enabled_state = _xgetbv(0);
+        __cpuidex(info, 7, 0);
+        if ((enabled_state & 0xe6) == 0xe6 and info[1] & 1 << 16) {
+            return InstructionSet::AVX512;
+        }
+        if ((enabled_state & 0x6) == 0x6 and info[1] & 1 << 5) {
+            return InstructionSet::AVX2;
+        }
+        return InstructionSet::SSE2;
+#elif defined(RENDERER_X86) and defined(__GNUC__)
+        // The builtins check operating system support as well as the processor
+        __builtin_cpu_init();
+        if (__builtin_cpu_supports("avx512f")) {
+            return InstructionSet::AVX512;
+        }
+        if (__builtin_cpu_supports("avx2")) {
+            return InstructionSet::AVX2;
+        }
+        if (__builtin_cpu_supports("sse2")) {
+            return InstructionSet::SSE2;
+        }
+        return InstructionSet::Scalar;
+#else
+        return InstructionSet::Scalar;
+#endif
+    }
+
+    InstructionSet select() {
+        const InstructionSet detected = CpuFeatures::detected();
+        const char* requested_name = std::getenv("RENDERER_ISA");
+        if (requested_name == nullptr or *requested_name == '\0') {
+            return detected;
+        }
+
+        const std::string name = requested_name;
+        InstructionSet requested;
+        if (name == "scalar") {
+            requested = InstructionSet::Scalar;
+        } else if (name == "sse2") {
+            requested = InstructionSet::SSE2;
+        } else if (name == "avx2") {
+            requested = InstructionSet::AVX2;
+        } else if (name == "avx512") {
+            requested = InstructionSet::AVX512;
+        } else {
+            throw std::runtime_error("Unknown RENDERER_ISA " + name + " (expected scalar, sse2, avx2 or avx512)");
+        }
+        if (requested > detected) {
+            std::clog << "RENDERER_ISA=" << name << " is not supported here, using " << instruction_set_name(detected) << '\n';
+            return detected;
+        }
+        return requested;
+    }
+}
+
+
+const char* instruction_set_name(const InstructionSet instruction_set) {
+    switch (instruction_set) {
+        case InstructionSet::Scalar: return "scalar";
+        case InstructionSet::SSE2: return "sse2";
+        case InstructionSet::AVX2: return "avx2";
+        case InstructionSet::AVX512: return "avx512";
+        default: return "unknown";
+    }
+}
+
+InstructionSet CpuFeatures::detected() {
+    static const InstructionSet instruction_set = detect();
+    return instruction_set;
+}
+
+InstructionSet CpuFeatures::active() {
+    static const InstructionSet instruction_set = select();
+    return instruction_set;
+}
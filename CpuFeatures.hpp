@@ -0,0 +1,36 @@
+#pragma once
+
+#include <cstdint>
+
+
+#if defined(_M_X64) or defined(_M_IX86) or defined(__x86_64__) or defined(__i386__)
+#define RENDERER_X86
+#endif
+
+// Lets one translation unit hold kernels for several instruction sets. MSVC accepts any
+// intrinsic without this; GCC and Clang need each function marked with the set it uses
+#if defined(RENDERER_X86) and defined(__GNUC__)
+#define RENDERER_TARGET(isa) __attribute__((target(isa)))
+#else
+#define RENDERER_TARGET(isa)
+#endif
+
+
+// Ordered, so that a later set implies every earlier one
+enum class InstructionSet : uint8_t {
+    Scalar,
+    SSE2,
+    AVX2,
+    AVX512
+};
+
+const char* instruction_set_name(InstructionSet);
+
+
+namespace CpuFeatures {
+    // The widest set both the processor and the operating system support
+    InstructionSet detected();
+    // The set kernels are bound to: the detected one, unless lowered through the
+    // RENDERER_ISA environment variable (scalar, sse2, avx2 or avx512) to test another path
+    InstructionSet active();
+}
@@ -1,17 +1,404 @@
 #include "Engine3D.hpp"
 
+#include "Statistics.hpp"
+#include "TiledLighting.hpp"
+
 #include <algorithm>
+#include <cmath>
+
+
+namespace {
+    // Triangles per geometry job, and the square of pixels each raster job owns
+    constexpr size_t geometry_chunk_size = 4096;
+    constexpr int tile_size = 64;
+
+    // Reprojection stands in for small camera moves only, and for a limited run of frames before a full redraw.
+    // Its tiles are smaller than the raster's so that a thin revealed strip costs little to draw
+    constexpr Scalar reprojection_max_distance = 0.5f;
+    constexpr Scalar reprojection_min_cosine = 0.995f;
+    constexpr int reprojection_max_frames = 8;
+    constexpr int reprojection_tile_size = 16;
+
+    Vector3D rotate_direction(const Matrix4x4& matrix, const Vector3D& direction) {
+        const auto rotated = matrix * Vector3D(direction.x, direction.y, direction.z, 0);
+        return { rotated.x, rotated.y, rotated.z };
+    }
+
+    // Splits a view-space triangle against the near plane, keeping its winding; returns how many triangles remain
+    size_t clip_against_near_plane(const Triangle& triangle, const Scalar near_plane, std::array<Triangle, 2>& output) {
+        std::array<Vector3D, 4> polygon;
+        size_t size = 0;
+        for (size_t i = 0; i < 3; ++i) {
+            const Vector3D& current = triangle.vertices[i];
+            const Vector3D& next = triangle.vertices[(i + 1) % 3];
+            const bool current_inside = current.z >= near_plane;
+            if (current_inside) {
+                polygon[size++] = current;
+            }
+            if (current_inside != (next.z >= near_plane)) {
+                const Scalar t = (near_plane - current.z) / (next.z - current.z);
+                polygon[size++] = current + (next - current) * t;
+            }
+        }
+        if (size < 3) {
+            return 0;
+        }
+        output[0] = { polygon[0], polygon[1], polygon[2] };
+        output[0].illumination = triangle.illumination;
+        if (size == 3) {
+            return 1;
+        }
+        output[1] = { polygon[0], polygon[2], polygon[3] };
+        output[1].illumination = triangle.illumination;
+        return 2;
+    }
+}
+
+
+void Engine3D::initialise() {
+    constexpr Scalar pi = 3.14159265358979323846f;
+    constexpr int light_count = 24;
+
+    const std::array<Vector3D, 3> palette = { Vector3D(1, 0.2f, 0.2f), Vector3D(0.2f, 1, 0.2f), Vector3D(0.2f, 0.2f, 1) };
+    for (int i = 0; i < light_count; ++i) {
+        const Scalar angle = 2 * pi * static_cast<Scalar>(i) / light_count;
+        _point_lights.push_back({ _scene_centre + Vector3D(3 * std::cos(angle), static_cast<Scalar>(i % 3) * 1.5f - 1, 3 * std::sin(angle)), palette[i % 3], 4 });
+    }
+    _view_point_lights = _point_lights;
 
+    if (_meshes.empty()) {
+        set_mesh("meshes/teapot.obj");
+    }
+
+    // Recordings and headless renders must not depend on how quickly assets load
+    if (recording() or headless()) {
+        for (const auto& mesh : _meshes) {
+            mesh.wait();
+        }
+    }
+}
 
 void Engine3D::update(const double frame_time) {
-    clear();
+    {
+        Statistics::ScopedTimer timer(Stage::Scene);
+        update_scene(static_cast<Scalar>(frame_time));
+        prepare_views();
+    }
+
+    auto inputs = frame_inputs(make_translation_matrix(_scene_centre) * make_rotation_matrix(_rotation));
+    if (inputs == _last_inputs) {
+        keep_frame();
+        return;
+    }
+
+    const GBufferUpdate g_buffer = g_buffer_update(inputs);
+    build_frame(inputs, g_buffer);
+    _frame.run(jobs());
+    if (g_buffer == GBufferUpdate::Reproject) {
+        ++_reprojected_frames;
+    } else if (g_buffer == GBufferUpdate::Redraw) {
+        _reprojected_frames = 0;
+    }
+    _last_inputs = std::move(inputs);
+}
+
+void Engine3D::set_reprojection(const bool reprojection) {
+    _reprojection = reprojection;
+    _previous_g_buffer = reprojection ? GBuffer(width(), height()) : GBuffer(0, 0);
+}
+
+Engine3D::FrameInputs Engine3D::frame_inputs(const Matrix4x4& world_matrix) const {
+    FrameInputs inputs;
+    inputs.world_matrix = world_matrix;
+    inputs.mesh_generation = _mesh_generation;
+    for (const auto& handle : _meshes) {
+        inputs.mesh_states.push_back(handle.state());
+    }
+    for (const auto& view : _frame_views) {
+        inputs.views.push_back({ view.position, view.direction, view.view_matrix, view.projection_matrix, view.viewport.minimum, view.viewport.maximum });
+    }
+    inputs.drawing_mode = _drawing_mode;
+    inputs.shadows = _shadows;
+    inputs.overlay = statistics_overlay();
+    inputs.sample_count = sample_count();
+    inputs.width = width();
+    inputs.height = height();
+    if (_drawing_mode == DrawingMode::Deferred) {
+        for (const auto& light : _point_lights) {
+            inputs.point_lights.push_back(light.position);
+        }
+    }
+    return inputs;
+}
+
+// The G-buffer only depends on the world and the camera, so moving lights alone just shade it again.
+// Added views draw over parts of the G-buffer, so both frames must have the main camera alone
+Engine3D::GBufferUpdate Engine3D::g_buffer_update(const FrameInputs& inputs) const {
+    const auto single_view = [](const FrameInputs& frame) {
+        return frame.drawing_mode == DrawingMode::Deferred and frame.views.size() == 1 and
+            frame.views[0].minimum == Coordinate{ 0, 0 } and frame.views[0].maximum == Coordinate{ frame.width, frame.height };
+    };
+    if (not _last_inputs or not single_view(inputs) or not single_view(*_last_inputs)) {
+        return GBufferUpdate::Redraw;
+    }
+    const auto& last = *_last_inputs;
+    if (inputs.world_matrix != last.world_matrix or not inputs.same_meshes(last) or inputs.width != last.width or inputs.height != last.height) {
+        return GBufferUpdate::Redraw;
+    }
+
+    const auto& view = inputs.views[0];
+    const auto& last_view = last.views[0];
+    if (view == last_view) {
+        // Once the camera settles, warped frames give way to an exact one
+        return _reprojected_frames > 0 ? GBufferUpdate::Redraw : GBufferUpdate::Keep;
+    }
+    if (not _reprojection or _reprojected_frames >= reprojection_max_frames) {
+        return GBufferUpdate::Redraw;
+    }
+    const bool small_move = (view.position - last_view.position).magnitude() <= reprojection_max_distance and
+        dot(view.direction.normalised(), last_view.direction.normalised()) >= reprojection_min_cosine;
+    return small_move ? GBufferUpdate::Reproject : GBufferUpdate::Redraw;
+}
+
+void Engine3D::set_camera(const Vector3D& position, const Vector3D& direction, const Scalar field_of_view) {
+    _camera.position = position;
+    _camera.direction = direction.normalised();
+    _field_of_view = field_of_view;
+    _mouse_look = false;
+}
+
+size_t Engine3D::add_view(const View& view) {
+    if (_views.size() + 1 >= max_views) {
+        throw std::runtime_error("At most " + std::to_string(max_views) + " views are supported");
+    }
+    _views.push_back(view);
+    return _views.size() - 1;
+}
+
+void Engine3D::prepare_views() {
+    size_t count = 0;
+    const auto prepare = [&](const View& view) {
+        const auto& area = view.viewport;
+        const Scissor viewport = {
+            {
+                std::clamp(static_cast<int>(std::lround(area.x * width())), 0, width()),
+                std::clamp(static_cast<int>(std::lround(area.y * height())), 0, height())
+            },
+            {
+                std::clamp(static_cast<int>(std::lround((area.x + area.width) * width())), 0, width()),
+                std::clamp(static_cast<int>(std::lround((area.y + area.height) * height())), 0, height())
+            }
+        };
+        if (viewport.minimum.x >= viewport.maximum.x or viewport.minimum.y >= viewport.maximum.y) {
+            return;
+        }
+        if (count == _frame_views.size()) {
+            _frame_views.emplace_back();
+        }
+        FrameView& frame_view = _frame_views[count++];
+        frame_view.position = view.position;
+        frame_view.direction = view.direction;
+        frame_view.view_matrix = make_view_matrix(view.position, view.position + view.direction);
+        frame_view.projection_matrix = make_projection_matrix(
+            { viewport.maximum.x - viewport.minimum.x, viewport.maximum.y - viewport.minimum.y }, view.field_of_view, _near_plane, _far_plane
+        );
+        frame_view.viewport = viewport;
+    };
+
+    prepare({ _camera.position, _camera.direction, _field_of_view, {} });
+    for (const auto& view : _views) {
+        prepare(view);
+    }
+    _frame_views.resize(count);
+}
+
+// Forward: shadow map, then geometry chunks, then per view a sort and binning, then a raster job per
+// screen tile drawing every view in order. Deferred: geometry chunks and the G-buffer clear, then per
+// view a G-buffer raster and shading, one view after another since they share the G-buffer.
+// The shadow map is only drawn again once the world has changed
+void Engine3D::build_frame(const FrameInputs& inputs, const GBufferUpdate g_buffer) {
+    using Task = TaskGraph::Task;
+    _frame.clear();
+    const bool deferred = _drawing_mode == DrawingMode::Deferred;
+    const auto& world_matrix = inputs.world_matrix;
+
+    std::vector<Task> shadow;
+    const bool shadow_map_current = _shadow_map_inputs and _shadow_map_inputs->world_matrix == world_matrix and _shadow_map_inputs->same_meshes(inputs);
+    if (_shadows and not shadow_map_current) {
+        _shadow_map_inputs.reset();
+        shadow.push_back(_frame.add("Shadow map", [this, world_matrix, inputs] {
+            Statistics::ScopedTimer timer(Stage::Shadow);
+            render_shadow_map(world_matrix);
+            _shadow_map_inputs = inputs;
+        }));
+    }
+
+    split_geometry();
+    std::vector<Task> geometry;
+    for (auto& chunk : _geometry_chunks) {
+        if (g_buffer != GBufferUpdate::Keep) {
+            // Only forward shading reads the shadow map during geometry
+            geometry.push_back(_frame.add("Geometry", [this, &chunk, world_matrix] {
+                Statistics::ScopedTimer timer(Stage::Geometry);
+                process_geometry(chunk, world_matrix);
+            }, deferred ? std::span<const Task>() : shadow));
+        }
+    }
+
+    if (deferred and g_buffer != GBufferUpdate::Redraw) {
+        std::vector<Task> shading_dependencies = shadow;
+        if (g_buffer == GBufferUpdate::Reproject) {
+            std::swap(_g_buffer, _previous_g_buffer);
+            const Task reprojection = _frame.add("Reprojection", [this, &previous = _last_inputs->views[0]] {
+                Statistics::ScopedTimer timer(Stage::Raster);
+                reproject_g_buffer(previous);
+            });
+            std::vector<Task> raster_dependencies = geometry;
+            raster_dependencies.push_back(reprojection);
+            shading_dependencies.push_back(_frame.add("Stale tile raster", [this] {
+                Statistics::ScopedTimer timer(Stage::Raster);
+                draw_stale_tiles();
+            }, raster_dependencies));
+        }
+        const Task shading = _frame.add("Shading", [this] {
+            Statistics::ScopedTimer timer(Stage::Shading);
+            shade_deferred(_frame_views[0]);
+        }, shading_dependencies);
+        _frame.add("Composite", [this] {
+            Statistics::ScopedTimer timer(Stage::Shading);
+            draw_image(_lit_pixels);
+        }, { shading });
+        return;
+    }
+
+    if (deferred) {
+        Task previous = _frame.add("G-buffer clear", [this] {
+            Statistics::ScopedTimer timer(Stage::Raster);
+            _g_buffer.clear();
+        });
+        for (size_t v = 0; v < _frame_views.size(); ++v) {
+            std::vector<Task> raster_dependencies = geometry;
+            raster_dependencies.push_back(previous);
+            std::vector<Task> shading_dependencies = shadow;
+            shading_dependencies.push_back(_frame.add("G-buffer raster", [this, v] {
+                Statistics::ScopedTimer timer(Stage::Raster);
+                const auto& viewport = _frame_views[v].viewport;
+                // Later views take over pixels that earlier views have finished shading
+                if (v > 0) {
+                    _g_buffer.clear(viewport.minimum, viewport.maximum);
+                }
+                for (const auto& chunk : _geometry_chunks) {
+                    const auto& view_geometry = chunk.views[v];
+                    for (size_t i = 0; i < view_geometry.triangles.size(); ++i) {
+                        _g_buffer.draw_triangle(view_geometry.triangles[i].vertices, view_geometry.normals[i], white, viewport.minimum, viewport.maximum);
+                    }
+                }
+            }, raster_dependencies));
+            previous = _frame.add("Shading", [this, v] {
+                Statistics::ScopedTimer timer(Stage::Shading);
+                shade_deferred(_frame_views[v]);
+            }, shading_dependencies);
+        }
+        _frame.add("Composite", [this] {
+            Statistics::ScopedTimer timer(Stage::Shading);
+            draw_image(_lit_pixels);
+        }, { previous });
+        return;
+    }
+
+    PipelineState::Fill fill;
+    switch (_drawing_mode) {
+        case DrawingMode::Filled: fill = PipelineState::Fill::Solid; break;
+        case DrawingMode::WireFrame: fill = PipelineState::Fill::Edges; break;
+        case DrawingMode::Both: fill = PipelineState::Fill::SolidWithEdges; break;
+        default: throw std::runtime_error("Invalid drawing mode");
+    }
+
+    std::vector<Task> sorts;
+    for (size_t v = 0; v < _frame_views.size(); ++v) {
+        sorts.push_back(_frame.add("Sort", [this, v] {
+            Statistics::ScopedTimer timer(Stage::Sort);
+            // Chunks are joined in submission order, so the result matches a single-threaded pass
+            auto& triangles = _frame_views[v].visible_mesh.triangles;
+            triangles.clear();
+            for (const auto& chunk : _geometry_chunks) {
+                triangles.insert(triangles.end(), chunk.views[v].triangles.begin(), chunk.views[v].triangles.end());
+            }
+            std::ranges::sort(
+                triangles.begin(), triangles.end(),
+                [](const Triangle& a, const Triangle& b) { return a.depth() < b.depth(); }
+            );
+            _frame_views[v].raster_triangles.resize(triangles.size());
+        }, geometry));
+    }
+
+    // Tiles only pay for their binning when there are threads to share them
+    if (jobs().thread_count() == 1) {
+        _frame.add("Raster", [this, fill] {
+            Statistics::ScopedTimer timer(Stage::Raster);
+            for (auto& view : _frame_views) {
+                for (size_t i = 0; i < view.raster_triangles.size(); ++i) {
+                    view.raster_triangles[i] = raster_triangle(view.visible_mesh.triangles[i]);
+                }
+                clear({ 0, 0, 0 }, view.viewport);
+                draw_triangles(view.raster_triangles, fill, { 0, 255, 0 }, view.viewport);
+            }
+        }, sorts);
+        return;
+    }
+
+    const size_t bin_count = jobs().thread_count();
+    const size_t tile_count = static_cast<size_t>(tiles_across()) * tiles_down();
+    std::vector<Task> bins;
+    for (size_t v = 0; v < _frame_views.size(); ++v) {
+        auto& tile_bins = _frame_views[v].tile_bins;
+        tile_bins.resize(bin_count);
+        for (size_t bin = 0; bin < bin_count; ++bin) {
+            tile_bins[bin].resize(tile_count);
+            bins.push_back(_frame.add("Binning", [this, v, bin, bin_count] {
+                Statistics::ScopedTimer timer(Stage::Raster);
+                bin_triangles(_frame_views[v], bin, bin_count);
+            }, { sorts[v] }));
+        }
+    }
+
+    for (size_t tile = 0; tile < tile_count; ++tile) {
+        _frame.add("Tile raster", [this, tile, fill] {
+            Statistics::ScopedTimer timer(Stage::Raster);
+            draw_tile(tile, fill);
+        }, bins);
+    }
+}
+
+void Engine3D::resize() {
+    _g_buffer = GBuffer(width(), height());
+    if (_reprojection) {
+        _previous_g_buffer = GBuffer(width(), height());
+    }
+    _lit_pixels.assign(static_cast<size_t>(width()) * height(), Pixel{ 0, 0, 0 });
+}
 
+void Engine3D::update_scene(const Scalar frame_time) {
     if (key('1') == ButtonState::Pressed) {
         _drawing_mode = DrawingMode::Filled;
     } else if (key('2') == ButtonState::Pressed) {
         _drawing_mode = DrawingMode::WireFrame;
     } else if (key('3') == ButtonState::Pressed) {
         _drawing_mode = DrawingMode::Both;
+    } else if (key('4') == ButtonState::Pressed) {
+        _drawing_mode = DrawingMode::Deferred;
+    }
+
+    if (key('h') == ButtonState::Pressed) {
+        _shadows = not _shadows;
+    }
+
+    if (key('o') == ButtonState::Pressed) {
+        set_statistics_overlay(not statistics_overlay());
+    }
+
+    if (key('m') == ButtonState::Pressed) {
+        set_sample_count(sample_count() == 8 ? 1 : sample_count() * 2);
     }
 
     if (key(Key::Space) == ButtonState::Held) {
@@ -49,12 +436,14 @@ void Engine3D::update(const double frame_time) {
         _camera.pitch += 2 * frame_time;
     }*/
 
-    constexpr double pi = 3.14159265358979323846;
+    constexpr Scalar pi = 3.14159265358979323846f;
 
-    _camera.yaw = 2 * pi * mouse_position().x / static_cast<double>(width()) - pi;
-    _camera.pitch = 2 * pi * mouse_position().y / static_cast<double>(height()) - pi;
+    if (_mouse_look) {
+        _camera.yaw = 2 * pi * static_cast<Scalar>(mouse_position().x) / static_cast<Scalar>(width()) - pi;
+        _camera.pitch = 2 * pi * static_cast<Scalar>(mouse_position().y) / static_cast<Scalar>(height()) - pi;
 
-    _camera.pitch = std::clamp(_camera.pitch, -pi / 2, pi / 2);
+        _camera.pitch = std::clamp(_camera.pitch, -pi / 2, pi / 2);
+    }
 
     if (key('r') == ButtonState::Pressed) {
         _rotation = { 0, 0, 0 };
@@ -63,101 +452,411 @@ void Engine3D::update(const double frame_time) {
         _auto_rotate = not _auto_rotate;
     }
     if (_auto_rotate) {
-        _rotation += {frame_time, 0, frame_time / 2};
+        _rotation += Vector3D(frame_time, 0, frame_time / 2);
     }
 
-    const auto world_matrix = make_translation_matrix(0, 0, 15) * make_rotation_matrix(_rotation);
-
-    const auto camera_rotation_matrix = make_rotation_matrix_y(_camera.yaw) * make_rotation_matrix_x(_camera.pitch);
-    const auto target = Vector3D(0, 0, 1);
-    _camera.direction = camera_rotation_matrix * target;
-    const auto view_matrix = make_view_matrix(_camera.position, _camera.position + _camera.direction);
+    const auto light_orbit = make_rotation_matrix_y(frame_time / 2);
+    for (auto& light : _point_lights) {
+        light.position = light_orbit * (light.position - _scene_centre) + _scene_centre;
+    }
 
-    Mesh visible_mesh;
+    if (_mouse_look) {
+        const auto camera_rotation_matrix = make_rotation_matrix_y(_camera.yaw) * make_rotation_matrix_x(_camera.pitch);
+        const auto target = Vector3D(0, 0, 1);
+        _camera.direction = camera_rotation_matrix * target;
+    }
+}
 
-    for (const auto& mesh : _meshes) {
-        for (auto triangle : mesh.triangles) {
-            // Rotate and translate
-            for (auto& vertex : triangle.vertices) {
-                vertex *= world_matrix;
+// Takes a snapshot of the meshes loaded so far, so every job in the frame sees the same set.
+// Chunks are reused from frame to frame to keep their buffers
+void Engine3D::split_geometry() {
+    size_t count = 0;
+    for (const auto& handle : _meshes) {
+        const QuantisedMesh* quantised = handle.quantised_mesh();
+        const Mesh* mesh = quantised == nullptr ? handle.mesh() : nullptr;
+        const size_t triangles = quantised != nullptr ? quantised->triangle_count() : mesh != nullptr ? mesh->triangles.size() : 0;
+        for (size_t begin = 0; begin < triangles; begin += geometry_chunk_size) {
+            if (count == _geometry_chunks.size()) {
+                _geometry_chunks.emplace_back();
             }
+            auto& chunk = _geometry_chunks[count++];
+            chunk.mesh = mesh;
+            chunk.quantised = quantised;
+            chunk.begin = begin;
+            chunk.end = std::min(begin + geometry_chunk_size, triangles);
+        }
+    }
+    _geometry_chunks.resize(count);
+}
 
-            if (_drawing_mode == DrawingMode::Filled) {
-                // Back face culling
-                if (auto camera_ray = triangle.vertices[0] - _camera.position;
-                    dot(triangle.normal(), camera_ray.normalised()) > 0) {
-                    continue;
-                }
+void Engine3D::process_geometry(GeometryChunk& chunk, const Matrix4x4& world_matrix) {
+    chunk.triangles.clear();
+    chunk.normals.clear();
+    chunk.facing.clear();
+    if (chunk.quantised != nullptr) {
+        process_quantised_mesh(chunk, world_matrix);
+    } else {
+        process_mesh(chunk, world_matrix);
+    }
+
+    // The chunk's world-space triangles are still in cache while every view takes its pass over them
+    chunk.views.resize(_frame_views.size());
+    for (size_t v = 0; v < _frame_views.size(); ++v) {
+        process_view(chunk, v);
+    }
+}
+
+uint32_t Engine3D::facing_views(const Vector3D& normal, const Vector3D& vertex) const {
+    if (_drawing_mode != DrawingMode::Filled and _drawing_mode != DrawingMode::Deferred) {
+        return ~0u;
+    }
+    uint32_t facing = 0;
+    for (size_t v = 0; v < _frame_views.size(); ++v) {
+        if (not (dot(normal, (vertex - _frame_views[v].position).normalised()) > 0)) {
+            facing |= 1u << v;
+        }
+    }
+    return facing;
+}
+
+void Engine3D::process_mesh(GeometryChunk& chunk, const Matrix4x4& world_matrix) {
+    auto& statistics = Statistics::local();
+    const bool shadowed = _shadows and _drawing_mode != DrawingMode::Deferred;
+
+    // Rotate and translate the whole chunk in one pass of the transform kernel
+    auto& vertices = chunk.world_vertices;
+    vertices.resize(3 * (chunk.end - chunk.begin));
+    for (size_t t = chunk.begin; t < chunk.end; ++t) {
+        std::ranges::copy(chunk.mesh->triangles[t].vertices, vertices.begin() + 3 * (t - chunk.begin));
+    }
+    transform_points<Scalar>(world_matrix, vertices, vertices);
+
+    for (size_t i = 0; i < vertices.size(); i += 3) {
+        Triangle triangle = { vertices[i], vertices[i + 1], vertices[i + 2] };
+        ++statistics.triangles_submitted;
+
+        // Back face culling, where no view sees the front
+        const auto normal = triangle.normal();
+        const uint32_t facing = facing_views(normal, triangle.vertices[0]);
+        if (facing == 0) {
+            ++statistics.triangles_back_face_culled;
+            continue;
+        }
+
+        triangle.illumination = dot(normal, _directional_light.direction);
+        if (shadowed) {
+            const auto centroid = (triangle.vertices[0] + triangle.vertices[1] + triangle.vertices[2]) / 3;
+            triangle.illumination *= static_cast<Scalar>(_shadow_map.visibility(_shadow_map.matrix() * centroid));
+        }
+
+        chunk.triangles.push_back(triangle);
+        chunk.normals.push_back(normal);
+        chunk.facing.push_back(facing);
+    }
+}
+
+void Engine3D::process_quantised_mesh(GeometryChunk& chunk, const Matrix4x4& world_matrix) {
+    auto& statistics = Statistics::local();
+    const QuantisedMesh& mesh = *chunk.quantised;
+    const bool shadowed = _shadows and _drawing_mode != DrawingMode::Deferred;
+
+    // Dequantisation is folded into the transform, so positions are decoded as they are transformed
+    const auto model_to_world = world_matrix * mesh.dequantisation_matrix();
+
+    // Direct-mapped post-transform cache; the load-time triangle order keeps most lookups hits
+    constexpr size_t cache_size = 256;
+    std::array<uint32_t, cache_size> tags;
+    tags.fill(~0u);
+    std::array<Vector3D, cache_size> cache;
+
+    mesh.for_each_triangle(chunk.begin, chunk.end, [&](const size_t t, const std::array<uint32_t, 3>& indices) {
+        ++statistics.triangles_submitted;
+
+        Triangle triangle;
+        for (size_t i = 0; i < 3; ++i) {
+            const size_t slot = indices[i] % cache_size;
+            if (tags[slot] != indices[i]) {
+                tags[slot] = indices[i];
+                cache[slot] = model_to_world * mesh.quantised_position(indices[i]);
             }
+            triangle.vertices[i] = cache[slot];
+        }
+
+        const auto normal = rotate_direction(world_matrix, mesh.normal(t));
+        const uint32_t facing = facing_views(normal, triangle.vertices[0]);
+        if (facing == 0) {
+            ++statistics.triangles_back_face_culled;
+            return;
+        }
 
-            const auto light_direction = Vector3D(0, 0, -1).normalised();
-            triangle.illumination = dot(triangle.normal(), light_direction);
+        triangle.illumination = dot(normal, _directional_light.direction);
+        if (shadowed) {
+            const auto centroid = (triangle.vertices[0] + triangle.vertices[1] + triangle.vertices[2]) / 3;
+            triangle.illumination *= static_cast<Scalar>(_shadow_map.visibility(_shadow_map.matrix() * centroid));
+        }
 
-            for (auto& vertex : triangle.vertices) {
-                // View
-                vertex *= view_matrix;
+        chunk.triangles.push_back(triangle);
+        chunk.normals.push_back(normal);
+        chunk.facing.push_back(facing);
+    });
+}
 
-                // Project
-                vertex *= _projection_matrix;
-                if (vertex.w != 0) {
-                    vertex /= vertex.w;
-                }
+void Engine3D::process_view(GeometryChunk& chunk, const size_t v) {
+    auto& statistics = Statistics::local();
+    const FrameView& view = _frame_views[v];
+    ViewGeometry& output = chunk.views[v];
+    output.triangles.clear();
+    output.normals.clear();
+
+    for (size_t i = 0; i < chunk.triangles.size(); ++i) {
+        if (not (chunk.facing[i] & 1u << v)) {
+            ++statistics.triangles_back_face_culled;
+            continue;
+        }
+
+        // View
+        auto triangle = chunk.triangles[i];
+        for (auto& vertex : triangle.vertices) {
+            vertex *= view.view_matrix;
+        }
+
+        submit_view_triangle(triangle, rotate_direction(view.view_matrix, chunk.normals[i]), view, output);
+    }
+}
+
+void Engine3D::submit_view_triangle(const Triangle& triangle, const Vector3D& view_normal, const FrameView& view, ViewGeometry& output) {
+    auto& statistics = Statistics::local();
+
+    if (std::ranges::all_of(triangle.vertices, [&](const Vector3D& vertex) { return vertex.z > _far_plane; })) {
+        ++statistics.triangles_frustum_culled;
+        return;
+    }
+
+    std::array<Triangle, 2> clipped;
+    const size_t count = clip_against_near_plane(triangle, _near_plane, clipped);
+    if (count == 0) {
+        ++statistics.triangles_frustum_culled;
+        return;
+    }
+    if (std::ranges::any_of(triangle.vertices, [&](const Vector3D& vertex) { return vertex.z < _near_plane; })) {
+        ++statistics.triangles_clipped;
+    }
 
-                // Scale into view
-                vertex += { 1, 1, 0 };
-                vertex.x *= static_cast<double>(width()) / 2;
-                vertex.y *= static_cast<double>(height()) / 2;
+    bool visible = false;
+    for (size_t i = 0; i < count; ++i) {
+        auto& part = clipped[i];
+        for (auto& vertex : part.vertices) {
+            // Project
+            vertex *= view.projection_matrix;
+            const Scalar w = vertex.w;
+            if (w != 0) {
+                vertex /= w;
             }
 
-            visible_mesh.triangles.push_back(triangle);
+            // Scale into the viewport
+            vertex += { 1, 1, 0 };
+            vertex.x *= static_cast<Scalar>(view.viewport.maximum.x - view.viewport.minimum.x) / 2;
+            vertex.y *= static_cast<Scalar>(view.viewport.maximum.y - view.viewport.minimum.y) / 2;
+            vertex.x += static_cast<Scalar>(view.viewport.minimum.x);
+            vertex.y += static_cast<Scalar>(view.viewport.minimum.y);
+
+            // Keep clip-space w for perspective-correct interpolation
+            vertex.w = w;
+        }
+
+        if (outside_viewport(part, view.viewport)) {
+            continue;
+        }
+
+        visible = true;
+        ++statistics.triangles_rasterised;
+        output.triangles.push_back(part);
+        if (_drawing_mode == DrawingMode::Deferred) {
+            output.normals.push_back(view_normal);
+        }
+    }
+    if (not visible) {
+        ++statistics.triangles_frustum_culled;
+    }
+}
+
+bool Engine3D::outside_viewport(const Triangle& triangle, const Scissor& viewport) {
+    const auto& [a, b, c] = triangle.vertices;
+    const auto& [minimum, maximum] = viewport;
+    return (a.x < minimum.x and b.x < minimum.x and c.x < minimum.x) or (a.x >= maximum.x and b.x >= maximum.x and c.x >= maximum.x) or
+        (a.y < minimum.y and b.y < minimum.y and c.y < minimum.y) or (a.y >= maximum.y and b.y >= maximum.y and c.y >= maximum.y);
+}
+
+void Engine3D::render_shadow_map(const Matrix4x4& world_matrix) {
+    const auto& direction = _directional_light.direction;
+    const auto up = std::abs(direction.y) > 0.99 ? Vector3D(1, 0, 0) : Vector3D(0, 1, 0);
+    const auto light_view = make_view_matrix(_scene_centre + direction * _shadow_extent * 2, _scene_centre, up);
+    const auto light_projection = make_orthographic_matrix(-_shadow_extent, _shadow_extent, -_shadow_extent, _shadow_extent, 0, _shadow_extent * 4);
+    _shadow_map.begin(light_projection * light_view);
+
+    const auto object_to_light = _shadow_map.matrix() * world_matrix;
+    for (const auto& handle : _meshes) {
+        if (const QuantisedMesh* quantised = handle.quantised_mesh()) {
+            const auto quantised_to_light = object_to_light * quantised->dequantisation_matrix();
+            quantised->for_each_triangle([&](size_t, const std::array<uint32_t, 3>& indices) {
+                _shadow_map.draw_triangle(quantised_to_light, {
+                    quantised->quantised_position(indices[0]), quantised->quantised_position(indices[1]), quantised->quantised_position(indices[2])
+                });
+            });
+            continue;
+        }
+        const Mesh* mesh = handle.mesh();
+        if (mesh == nullptr) {
+            continue;
         }
+        for (const auto& triangle : mesh->triangles) {
+            _shadow_map.draw_triangle(object_to_light, triangle.vertices);
+        }
+    }
+}
+
+void Engine3D::shade_deferred(const FrameView& view) {
+    for (size_t i = 0; i < _point_lights.size(); ++i) {
+        _view_point_lights[i].position = view.view_matrix * _point_lights[i].position;
     }
+    const DirectionalLight view_directional_light = {
+        rotate_direction(view.view_matrix, _directional_light.direction).normalised(),
+        _directional_light.colour
+    };
+    const TiledLightingInput input = {
+        view.projection_matrix[0][0], view.projection_matrix[1][1],
+        view_directional_light, _view_point_lights,
+        _shadows ? &_shadow_map : nullptr, _shadow_map.matrix() * make_camera_matrix(view.position, view.position + view.direction),
+        view.viewport.minimum, view.viewport.maximum
+    };
+    shade_tiled(jobs(), _g_buffer, input, _lit_pixels);
+}
 
-    std::ranges::sort(
-        visible_mesh.triangles.begin(), visible_mesh.triangles.end(),
-        [](const Triangle& a, const Triangle& b) { return a.depth() < b.depth(); }
+void Engine3D::reproject_g_buffer(const FrameInputs::ViewInputs& previous) {
+    const FrameView& view = _frame_views[0];
+    _g_buffer.reproject(
+        _previous_g_buffer, view.view_matrix * make_camera_matrix(previous.position, previous.position + previous.direction), previous.projection_matrix, view.projection_matrix,
+        reprojection_tile_size, _stale_tiles
     );
+}
 
-    draw_mesh(visible_mesh);
-    //draw_wire_frame_mesh(visible_mesh);
+// Redraws the tiles the warp left uncovered, in full, from the main view's triangles
+void Engine3D::draw_stale_tiles() {
+    if (std::ranges::find(_stale_tiles, 1) == _stale_tiles.end()) {
+        return;
+    }
+    const int across = (width() + reprojection_tile_size - 1) / reprojection_tile_size;
+    const int down = (height() + reprojection_tile_size - 1) / reprojection_tile_size;
+    const auto tile_minimum = [&](const int x, const int y) { return Coordinate{ x * reprojection_tile_size, y * reprojection_tile_size }; };
+    const auto tile_maximum = [&](const int x, const int y) { return tile_minimum(x, y) + Coordinate{ reprojection_tile_size, reprojection_tile_size }; };
+    for (int y = 0; y < down; ++y) {
+        for (int x = 0; x < across; ++x) {
+            if (_stale_tiles[static_cast<size_t>(y) * across + x]) {
+                _g_buffer.clear(tile_minimum(x, y), tile_maximum(x, y));
+            }
+        }
+    }
+
+    for (const auto& chunk : _geometry_chunks) {
+        const auto& view_geometry = chunk.views[0];
+        for (size_t i = 0; i < view_geometry.triangles.size(); ++i) {
+            const auto& [a, b, c] = view_geometry.triangles[i].vertices;
+            const int first_x = std::max(static_cast<int>(std::floor(std::min({ a.x, b.x, c.x }))), 0) / reprojection_tile_size;
+            const int first_y = std::max(static_cast<int>(std::floor(std::min({ a.y, b.y, c.y }))), 0) / reprojection_tile_size;
+            const int last_x = std::min(static_cast<int>(std::ceil(std::max({ a.x, b.x, c.x }))) / reprojection_tile_size, across - 1);
+            const int last_y = std::min(static_cast<int>(std::ceil(std::max({ a.y, b.y, c.y }))) / reprojection_tile_size, down - 1);
+            for (int y = first_y; y <= last_y; ++y) {
+                for (int x = first_x; x <= last_x; ++x) {
+                    if (_stale_tiles[static_cast<size_t>(y) * across + x]) {
+                        _g_buffer.draw_triangle(view_geometry.triangles[i].vertices, view_geometry.normals[i], white, tile_minimum(x, y), tile_maximum(x, y));
+                    }
+                }
+            }
+        }
+    }
 }
 
-void Engine3D::draw_mesh(const Mesh& mesh) {
-    switch (_drawing_mode) {
-        case DrawingMode::Filled:
-            draw_filled_mesh(mesh);
-            break;
-        case DrawingMode::WireFrame:
-            draw_wire_frame_mesh(mesh);
-            break;
-        case DrawingMode::Both:
-            draw_filled_mesh(mesh);
-            draw_wire_frame_mesh(mesh);
-            break;
-        default:
-            throw std::runtime_error("Invalid drawing mode");
+int Engine3D::tiles_across() const {
+    return (width() + tile_size - 1) / tile_size;
+}
+
+int Engine3D::tiles_down() const {
+    return (height() + tile_size - 1) / tile_size;
+}
+
+Renderer::RasterTriangle Engine3D::raster_triangle(const Triangle& triangle) {
+    RasterTriangle raster_triangle;
+    std::array<Coordinate, 3> subpixel_coordinates;
+    for (uint8_t i = 0; i < 3; ++i) {
+        const Vector3D& vertex = triangle.vertices[i];
+        raster_triangle.coordinates[i] = { static_cast<int>(vertex.x), static_cast<int>(vertex.y) };
+        subpixel_coordinates[i] = { static_cast<int>(std::lround(vertex.x * subpixel)), static_cast<int>(std::lround(vertex.y * subpixel)) };
     }
+    raster_triangle.subpixel_coordinates = subpixel_coordinates;
+    // Back faces have negative illumination; converting through int keeps that defined
+    const auto brightness = static_cast<uint8_t>(static_cast<int>(triangle.illumination * 255));
+    raster_triangle.fill = { brightness, brightness, brightness };
+    return raster_triangle;
 }
 
-void Engine3D::draw_filled_mesh(const Mesh& mesh) {
-    for (const auto& triangle : mesh.triangles) {
-        std::array<Coordinate, 3> coordinates;
-        for (uint8_t i = 0; i < 3; ++i) {
-            coordinates[i] = { static_cast<int>(triangle.vertices[i].x), static_cast<int>(triangle.vertices[i].y) };
+// Converts an equal share of a view's sorted triangles and lists each under every tile its bounds touch.
+// Shares are in order, so reading the bins in order keeps each tile's triangles back to front
+void Engine3D::bin_triangles(FrameView& view, const size_t bin, const size_t bin_count) {
+    const auto& triangles = view.visible_mesh.triangles;
+    const size_t begin = triangles.size() * bin / bin_count;
+    const size_t end = triangles.size() * (bin + 1) / bin_count;
+    auto& tiles = view.tile_bins[bin];
+    for (auto& tile : tiles) {
+        tile.clear();
+    }
+
+    const int across = tiles_across();
+    const auto& viewport = view.viewport;
+    for (size_t i = begin; i < end; ++i) {
+        view.raster_triangles[i] = raster_triangle(triangles[i]);
+
+        // Below the middle vertex fill_triangle restarts the long edge from the middle vertex, so spans
+        // can reach up to the triangle's width past its bounds
+        const auto& [a, b, c] = view.raster_triangles[i].coordinates;
+        const int margin = std::max({ a.x, b.x, c.x }) - std::min({ a.x, b.x, c.x }) + 2;
+        const Coordinate minimum = { std::min({ a.x, b.x, c.x }) - margin, std::min({ a.y, b.y, c.y }) };
+        const Coordinate maximum = { std::max({ a.x, b.x, c.x }) + margin, std::max({ a.y, b.y, c.y }) };
+        if (maximum.x < viewport.minimum.x or maximum.y < viewport.minimum.y or minimum.x >= viewport.maximum.x or minimum.y >= viewport.maximum.y) {
+            continue;
+        }
+        const int first_x = std::max(minimum.x, viewport.minimum.x) / tile_size;
+        const int first_y = std::max(minimum.y, viewport.minimum.y) / tile_size;
+        const int last_x = std::min(maximum.x, viewport.maximum.x - 1) / tile_size;
+        const int last_y = std::min(maximum.y, viewport.maximum.y - 1) / tile_size;
+        for (int y = first_y; y <= last_y; ++y) {
+            for (int x = first_x; x <= last_x; ++x) {
+                tiles[static_cast<size_t>(y) * across + x].push_back(static_cast<uint32_t>(i));
+            }
         }
-        const auto brightness = static_cast<uint8_t>(triangle.illumination * 255);
-        draw_filled_triangle(coordinates, { brightness, brightness, brightness });
     }
 }
 
-void Engine3D::draw_wire_frame_mesh(const Mesh& mesh) {
-    for (const auto& triangle : mesh.triangles) {
-        std::array<Coordinate, 3> coordinates;
-        for (uint8_t i = 0; i < 3; ++i) {
-            coordinates[i] = { static_cast<int>(triangle.vertices[i].x), static_cast<int>(triangle.vertices[i].y) };
+void Engine3D::draw_tile(const size_t tile, const PipelineState::Fill fill) {
+    const int x = static_cast<int>(tile % tiles_across()) * tile_size;
+    const int y = static_cast<int>(tile / tiles_across()) * tile_size;
+
+    thread_local std::vector<RasterTriangle> triangles;
+    for (const auto& view : _frame_views) {
+        const Scissor scissor = {
+            { std::max(x, view.viewport.minimum.x), std::max(y, view.viewport.minimum.y) },
+            { std::min(x + tile_size, view.viewport.maximum.x), std::min(y + tile_size, view.viewport.maximum.y) }
+        };
+        if (scissor.minimum.x >= scissor.maximum.x or scissor.minimum.y >= scissor.maximum.y) {
+            continue;
+        }
+        clear({ 0, 0, 0 }, scissor);
+
+        triangles.clear();
+        for (const auto& bin : view.tile_bins) {
+            for (const uint32_t i : bin[tile]) {
+                triangles.push_back(view.raster_triangles[i]);
+            }
         }
-        //const auto brightness = static_cast<uint8_t>(triangle.illumination * 255);
-        //draw_triangle(coordinates, { brightness, brightness, brightness });
-        draw_triangle(coordinates, { 0, 255, 0 });
+        draw_triangles(triangles, fill, { 0, 255, 0 }, scissor);
     }
-}
\ No newline at end of file
+}
@@ -2,26 +2,72 @@
 
 #include "Renderer.hpp"
 
+#include "GBuffer.hpp"
+#include "Light.hpp"
 #include "Mesh.hpp"
+#include "MeshLoader.hpp"
+#include "ShadowMap.hpp"
+#include "TaskGraph.hpp"
 #include "Matrix4x4.hpp"
 #include "Vector3D.hpp"
 
+#include <optional>
+
 
 class Engine3D final : public Renderer {
 public:
+    // Where a view is drawn, in fractions of the frame's width and height
+    struct Viewport {
+        double x = 0;
+        double y = 0;
+        double width = 1;
+        double height = 1;
+    };
+    struct View {
+        Vector3D position;
+        Vector3D direction = { 0, 0, 1 };
+        Scalar field_of_view = 90;
+        Viewport viewport;
+    };
+    // The main camera counts as one
+    static constexpr size_t max_views = 32;
+
+    enum class DrawingMode : uint8_t {
+        WireFrame,
+        Filled,
+        Both,
+        Deferred
+    };
+
     using Renderer::Renderer;
+    void initialise() override;
     void update(double frame_time) override;
+    void resize() override;
+    void set_auto_rotate(bool auto_rotate) { _auto_rotate = auto_rotate; }
+    void set_mesh(const std::string& filename, const MeshLoadOptions& options = {}) { set_mesh(_mesh_loader.load(filename, options)); }
+    void set_mesh(const MeshHandle& mesh) { _meshes = { mesh }; ++_mesh_generation; }
+    void set_drawing_mode(DrawingMode drawing_mode) { _drawing_mode = drawing_mode; }
+    // Places the main camera, which the mouse then no longer turns. Meshes sit at the scene centre, (0, 0, 15)
+    void set_camera(const Vector3D& position, const Vector3D& direction, Scalar field_of_view = 90);
+    // Adds a camera drawn after, and so over, the main one, and returns its index for view().
+    // World-space geometry and lighting are shared by every view; only view-dependent work is repeated
+    size_t add_view(const View&);
+    View& view(size_t index) { return _views.at(index); }
+    // Deferred frames after a small camera move warp the last G-buffer rather than redraw it, and
+    // only draw the tiles it leaves uncovered. Applies while the main camera is the only view
+    void set_reprojection(bool reprojection);
 private:
-    std::vector<Mesh> _meshes = {
-        Mesh("meshes/teapot.obj"),
-        //Mesh("meshes/axes.obj"),
-    };
+    MeshLoader _mesh_loader;
+    // The teapot is loaded on initialise if no mesh has been set by then
+    std::vector<MeshHandle> _meshes;
+    // Counts changes to the set of meshes, so a frame can tell them apart even if a new mesh reuses an old one's memory
+    uint64_t _mesh_generation = 0;
 
-    double _field_of_view = 90;
-    double _near_plane = 0.1;
-    double _far_plane = 1000;
+    Scalar _field_of_view = 90;
+    Scalar _near_plane = 0.1f;
+    Scalar _far_plane = 1000;
 
-    Matrix4x4 _projection_matrix = make_projection_matrix({ width(), height() }, _field_of_view, _near_plane, _far_plane);
+    Vector3D _scene_centre = { 0, 0, 15 };
 
     bool _auto_rotate = false;
     Vector3D _rotation = { 0, 0, 0 };
@@ -29,17 +75,126 @@ private:
     struct {
         Vector3D position = { 0, 2, 10 };
         Vector3D direction = { 0, 0, 1 };
-        double yaw = 0;
-        double pitch = 0;
+        Scalar yaw = 0;
+        Scalar pitch = 0;
     } _camera;
+    bool _mouse_look = true;
 
-    enum class DrawingMode : uint8_t {
-        WireFrame,
-        Filled,
-        Both
-    } _drawing_mode = DrawingMode::WireFrame;
+    DirectionalLight _directional_light = { { 0, 0, -1 }, { 0.25f, 0.25f, 0.25f } };
+    std::vector<PointLight> _point_lights;
+    std::vector<PointLight> _view_point_lights;
+
+    bool _shadows = true;
+    Scalar _shadow_extent = 6;
+    ShadowMap _shadow_map{ 1024 };
+
+    std::vector<View> _views;
+
+    // A view as the frame's jobs see it: the main camera first, then every added view that covers any pixels
+    struct FrameView {
+        Vector3D position;
+        Vector3D direction;
+        Matrix4x4 view_matrix;
+        Matrix4x4 projection_matrix;
+        Scissor viewport;
+        Mesh visible_mesh;
+        std::vector<RasterTriangle> raster_triangles;
+        // For every binning job, each screen tile's triangles as indices into raster_triangles
+        std::vector<std::vector<std::vector<uint32_t>>> tile_bins;
+    };
+    std::vector<FrameView> _frame_views;
+
+    // The triangles one view keeps from a chunk, projected into its viewport
+    struct ViewGeometry {
+        std::vector<Triangle> triangles;
+        std::vector<Vector3D> normals;
+    };
+    // A run of one mesh's triangles, taken through geometry by a single job. The world-space
+    // triangles, lit, are shared by the views, with a mask of the views each one faces
+    struct GeometryChunk {
+        const Mesh* mesh = nullptr;
+        const QuantisedMesh* quantised = nullptr;
+        size_t begin = 0;
+        size_t end = 0;
+        // The corners of a plain mesh's triangles, three per triangle, in world space
+        std::vector<Vector3D> world_vertices;
+        std::vector<Triangle> triangles;
+        std::vector<Vector3D> normals;
+        std::vector<uint32_t> facing;
+        std::vector<ViewGeometry> views;
+    };
+    std::vector<GeometryChunk> _geometry_chunks;
+
+    TaskGraph _frame;
+
+    GBuffer _g_buffer{ width(), height() };
+    std::vector<Pixel> _lit_pixels = std::vector<Pixel>(static_cast<size_t>(width()) * height());
+
+    DrawingMode _drawing_mode = DrawingMode::WireFrame;
+
+    // Everything a frame's image depends on, so that a frame with the same inputs as the last need not be drawn
+    struct FrameInputs {
+        struct ViewInputs {
+            Vector3D position;
+            Vector3D direction;
+            Matrix4x4 view_matrix;
+            Matrix4x4 projection_matrix;
+            Coordinate minimum;
+            Coordinate maximum;
+            bool operator==(const ViewInputs&) const = default;
+        };
+        Matrix4x4 world_matrix;
+        // The meshes drawn, and how far each has loaded
+        uint64_t mesh_generation = 0;
+        std::vector<MeshHandle::State> mesh_states;
+        std::vector<ViewInputs> views;
+        DrawingMode drawing_mode = DrawingMode::WireFrame;
+        bool shadows = false;
+        bool overlay = false;
+        int sample_count = 1;
+        int width = 0;
+        int height = 0;
+        // Only deferred shading reads the point lights
+        std::vector<Vector3D> point_lights;
+        bool operator==(const FrameInputs&) const = default;
+        bool same_meshes(const FrameInputs& other) const { return mesh_generation == other.mesh_generation and mesh_states == other.mesh_states; }
+    };
+    std::optional<FrameInputs> _last_inputs;
+    // The inputs of the frame that last drew the shadow map, which only depends on the world
+    std::optional<FrameInputs> _shadow_map_inputs;
+
+    // How a deferred frame fills the G-buffer: drawn afresh, left as the last frame's, or warped from it
+    enum class GBufferUpdate : uint8_t {
+        Redraw,
+        Keep,
+        Reproject
+    };
+    bool _reprojection = false;
+    int _reprojected_frames = 0;
+    GBuffer _previous_g_buffer{ 0, 0 };
+    std::vector<uint8_t> _stale_tiles;
 
-    void draw_mesh(const Mesh& mesh);
-    void draw_filled_mesh(const Mesh&);
-    void draw_wire_frame_mesh(const Mesh&);
+    void update_scene(Scalar frame_time);
+    void prepare_views();
+    FrameInputs frame_inputs(const Matrix4x4& world_matrix) const;
+    GBufferUpdate g_buffer_update(const FrameInputs&) const;
+    void build_frame(const FrameInputs&, GBufferUpdate);
+    void split_geometry();
+    void process_geometry(GeometryChunk&, const Matrix4x4& world_matrix);
+    void process_mesh(GeometryChunk&, const Matrix4x4& world_matrix);
+    void process_quantised_mesh(GeometryChunk&, const Matrix4x4& world_matrix);
+    // Bit v is set for every view v that sees the front of a triangle, or for all when nothing is culled
+    uint32_t facing_views(const Vector3D& normal, const Vector3D& vertex) const;
+    void process_view(GeometryChunk&, size_t view);
+    void submit_view_triangle(const Triangle&, const Vector3D& view_normal, const FrameView&, ViewGeometry&);
+    static bool outside_viewport(const Triangle&, const Scissor&);
+    void render_shadow_map(const Matrix4x4& world_matrix);
+    void shade_deferred(const FrameView&);
+    void reproject_g_buffer(const FrameInputs::ViewInputs& previous);
+    void draw_stale_tiles();
+    static RasterTriangle raster_triangle(const Triangle&);
+    void bin_triangles(FrameView&, size_t bin, size_t bin_count);
+    void draw_tile(size_t tile, PipelineState::Fill);
+    int tiles_across() const;
+    int tiles_down() const;
 };
\ No newline at end of file
@@ -0,0 +1,231 @@
+#include "FrameWriter.hpp"
+
+#include <algorithm>
+#include <cctype>
+#include <stdexcept>
+#include <string_view>
+
+#ifdef _WIN32
+#include <fcntl.h>
+#include <io.h>
+#endif
+
+
+static_assert(sizeof(Pixel) == 4, "Raw frames are written straight from Pixel memory");
+
+
+FrameWriter::FrameWriter(const std::string& path, const Format format, const int width, const int height, const int frame_rate, const size_t buffer_count) :
+    _path(path), _format(format), _width(width), _height(height), _frame_rate(frame_rate),
+    _frames(std::max<size_t>(buffer_count, 1), std::vector<Pixel>(static_cast<size_t>(width) * height)) {
+    if (width <= 0 or height <= 0 or frame_rate <= 0) {
+        throw std::runtime_error("Invalid frame writer dimensions or frame rate");
+    }
+
+    const size_t pixel_count = static_cast<size_t>(width) * height;
+    const size_t chroma_count = static_cast<size_t>((width + 1) / 2) * ((height + 1) / 2);
+
+    switch (_format) {
+        case Format::PPMSequence:
+            parse_sequence_pattern();
+            _scratch.resize(pixel_count * 3);
+            break;
+        case Format::Y4M:
+        case Format::Raw:
+            if (_path == "-") {
+#ifdef _WIN32
+                _setmode(_fileno(stdout), _O_BINARY);
+#endif
+                _file = stdout;
+            } else {
+                _file = std::fopen(_path.c_str(), "wb");
+                if (_file == nullptr) {
+                    throw std::runtime_error("Could not open file " + _path);
+                }
+            }
+            std::setvbuf(_file, nullptr, _IOFBF, 1 << 20);
+            if (_format == Format::Y4M) {
+                _scratch.resize(pixel_count + 2 * chroma_count);
+                std::fprintf(_file, "YUV4MPEG2 W%d H%d F%d:1 Ip A1:1 C420jpeg\n", _width, _height, _frame_rate);
+            }
+            break;
+        default:
+            throw std::runtime_error("Invalid frame format");
+    }
+
+    _thread = std::thread(&FrameWriter::write_loop, this);
+}
+
+FrameWriter::~FrameWriter() {
+    {
+        std::lock_guard lock(_mutex);
+        _stopping = true;
+    }
+    _frame_queued.notify_one();
+    _thread.join();
+
+    if (_file == stdout) {
+        std::fflush(_file);
+    } else if (_file != nullptr) {
+        std::fclose(_file);
+    }
+}
+
+std::span<Pixel> FrameWriter::acquire() {
+    std::unique_lock lock(_mutex);
+    if (_acquired) {
+        throw std::runtime_error("Frame acquired twice without being submitted");
+    }
+    _frame_written.wait(lock, [this] { return _queued < _frames.size() or _error != nullptr; });
+    if (_error != nullptr) {
+        std::rethrow_exception(_error);
+    }
+    _acquired = true;
+    return _frames[_next_free];
+}
+
+void FrameWriter::submit() {
+    {
+        std::lock_guard lock(_mutex);
+        if (not _acquired) {
+            throw std::runtime_error("Frame submitted without being acquired");
+        }
+        _acquired = false;
+        _next_free = (_next_free + 1) % _frames.size();
+        ++_queued;
+    }
+    _frame_queued.notify_one();
+}
+
+// The filename is built here rather than by printf, so a path can never reach it as a format string
+void FrameWriter::parse_sequence_pattern() {
+    const auto invalid = [&] {
+        return std::runtime_error("PPM sequence path " + _path + " must contain exactly one frame number pattern, such as %05d, and %% for any other %");
+    };
+    bool found = false;
+    std::string* part = &_sequence_prefix;
+    for (size_t i = 0; i < _path.size(); ++i) {
+        if (_path[i] != '%') {
+            part->push_back(_path[i]);
+            continue;
+        }
+        if (i + 1 < _path.size() and _path[i + 1] == '%') {
+            part->push_back('%');
+            ++i;
+            continue;
+        }
+        // Only an optional zero flag and width may come between the % and d, i or u
+        size_t end = i + 1;
+        while (end < _path.size() and std::isdigit(static_cast<unsigned char>(_path[end]))) {
+            ++end;
+        }
+        if (found or end >= _path.size() or std::string_view("diu").find(_path[end]) == std::string_view::npos or end - i > 3) {
+            throw invalid();
+        }
+        _sequence_zero_padded = _path[i + 1] == '0';
+        _sequence_width = end > i + 1 ? std::stoul(_path.substr(i + 1, end - i - 1)) : 0;
+        found = true;
+        part = &_sequence_suffix;
+        i = end;
+    }
+    if (not found) {
+        throw invalid();
+    }
+}
+
+void FrameWriter::write_loop() {
+    while (true) {
+        std::unique_lock lock(_mutex);
+        _frame_queued.wait(lock, [this] { return _queued > 0 or _stopping; });
+        if (_queued == 0) {
+            return;
+        }
+        const auto& frame = _frames[_next_queued];
+        lock.unlock();
+
+        try {
+            write_frame(frame);
+        } catch (...) {
+            lock.lock();
+            _error = std::current_exception();
+            lock.unlock();
+            _frame_written.notify_one();
+            return;
+        }
+
+        lock.lock();
+        _next_queued = (_next_queued + 1) % _frames.size();
+        --_queued;
+        lock.unlock();
+        _frame_written.notify_one();
+    }
+}
+
+void FrameWriter::write_frame(const std::vector<Pixel>& frame) {
+    switch (_format) {
+        case Format::PPMSequence: {
+            std::string number = std::to_string(_frame_number);
+            if (number.size() < _sequence_width) {
+                number.insert(0, _sequence_width - number.size(), _sequence_zero_padded ? '0' : ' ');
+            }
+            const std::string filename = _sequence_prefix + number + _sequence_suffix;
+            _file = std::fopen(filename.c_str(), "wb");
+            if (_file == nullptr) {
+                throw std::runtime_error("Could not open file " + filename);
+            }
+            for (size_t i = 0; i < frame.size(); ++i) {
+                _scratch[i * 3 + 0] = frame[i].red;
+                _scratch[i * 3 + 1] = frame[i].green;
+                _scratch[i * 3 + 2] = frame[i].blue;
+            }
+            std::fprintf(_file, "P6\n%d %d\n255\n", _width, _height);
+            write(_scratch.data(), _scratch.size());
+            std::fclose(_file);
+            _file = nullptr;
+            break;
+        }
+        case Format::Y4M: {
+            // Full-range BT.601, as implied by C420jpeg, in 8.8 fixed point
+            const int chroma_width = (_width + 1) / 2;
+            const int chroma_height = (_height + 1) / 2;
+            uint8_t* const luma = _scratch.data();
+            uint8_t* const blue_difference = luma + static_cast<size_t>(_width) * _height;
+            uint8_t* const red_difference = blue_difference + static_cast<size_t>(chroma_width) * chroma_height;
+            for (size_t i = 0; i < frame.size(); ++i) {
+                luma[i] = static_cast<uint8_t>((77 * frame[i].red + 150 * frame[i].green + 29 * frame[i].blue + 128) >> 8);
+            }
+            for (int y = 0; y < chroma_height; ++y) {
+                for (int x = 0; x < chroma_width; ++x) {
+                    int red = 0, green = 0, blue = 0, count = 0;
+                    for (int dy = 0; dy < 2 and y * 2 + dy < _height; ++dy) {
+                        for (int dx = 0; dx < 2 and x * 2 + dx < _width; ++dx) {
+                            const Pixel& pixel = frame[static_cast<size_t>(y * 2 + dy) * _width + x * 2 + dx];
+                            red += pixel.red;
+                            green += pixel.green;
+                            blue += pixel.blue;
+                            ++count;
+                        }
+                    }
+                    red /= count;
+                    green /= count;
+                    blue /= count;
+                    const size_t index = static_cast<size_t>(y) * chroma_width + x;
+                    blue_difference[index] = static_cast<uint8_t>(std::clamp(((-43 * red - 85 * green + 128 * blue + 128) >> 8) + 128, 0, 255));
+                    red_difference[index] = static_cast<uint8_t>(std::clamp(((128 * red - 107 * green - 21 * blue + 128) >> 8) + 128, 0, 255));
+                }
+            }
+            write("FRAME\n", 6);
+            write(_scratch.data(), _scratch.size());
+            break;
+        }
+        case Format::Raw:
+            write(frame.data(), frame.size() * sizeof(Pixel));
+            break;
+    }
+    ++_frame_number;
+}
+
+void FrameWriter::write(const void* const data, const size_t size) {
+    if (std::fwrite(data, 1, size, _file) != size) {
+        throw std::runtime_error("Could not write frame " + std::to_string(_frame_number) + " to " + _path);
+    }
+}
@@ -0,0 +1,66 @@
+#pragma once
+
+#include "Pixel.hpp"
+
+#include <condition_variable>
+#include <cstdio>
+#include <exception>
+#include <mutex>
+#include <span>
+#include <string>
+#include <thread>
+#include <vector>
+
+
+// Streams finished frames to disk or a pipe from a background thread. Frames are staged
+// in a fixed ring of buffers allocated up front, so the render loop only ever copies
+// into a free slot, and only waits when every slot is still queued for writing
+class FrameWriter {
+public:
+    enum class Format : uint8_t {
+        PPMSequence, // One binary PPM per frame; the path holds one printf-style integer such as "frames/%05d.ppm", and %% for a literal %
+        Y4M,         // YUV4MPEG2 stream, 4:2:0 chroma
+        Raw          // Tightly packed RGBA8 frames; "-" writes to standard output
+    };
+
+    FrameWriter(const std::string& path, Format, int width, int height, int frame_rate = 30, size_t buffer_count = 3);
+    ~FrameWriter();
+    FrameWriter(const FrameWriter&) = delete;
+    FrameWriter& operator=(const FrameWriter&) = delete;
+
+    std::span<Pixel> acquire();
+    void submit();
+
+    int frame_rate() const { return _frame_rate; }
+private:
+    void parse_sequence_pattern();
+    void write_loop();
+    void write_frame(const std::vector<Pixel>&);
+    void write(const void* data, size_t size);
+
+    std::string _path;
+    Format _format;
+    int _width;
+    int _height;
+    int _frame_rate;
+    std::FILE* _file = nullptr;
+    std::vector<uint8_t> _scratch;
+    // A PPM sequence path split around its frame number
+    std::string _sequence_prefix;
+    std::string _sequence_suffix;
+    size_t _sequence_width = 0;
+    bool _sequence_zero_padded = false;
+    uint64_t _frame_number = 0;
+
+    std::vector<std::vector<Pixel>> _frames;
+    size_t _next_free = 0;
+    size_t _next_queued = 0;
+    size_t _queued = 0;
+    bool _acquired = false;
+    bool _stopping = false;
+    std::exception_ptr _error;
+    std::mutex _mutex;
+    std::condition_variable _frame_queued;
+    std::condition_variable _frame_written;
+    std::thread _thread;
+};
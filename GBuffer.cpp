@@ -0,0 +1,211 @@
+#include "GBuffer.hpp"
+
+#include "Statistics.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+
+
+namespace {
+    // A warped pixel counts as showing through a crack when both neighbours across it are this much nearer
+    constexpr float crack_depth_ratio = 0.95f;
+}
+
+
+GBuffer::GBuffer(const int width, const int height) :
+    _width(width), _height(height),
+    _depth(static_cast<size_t>(width) * height, std::numeric_limits<float>::infinity()),
+    _normals(static_cast<size_t>(width) * height),
+    _albedo(static_cast<size_t>(width) * height) {}
+
+void GBuffer::clear() {
+    std::ranges::fill(_depth, std::numeric_limits<float>::infinity());
+}
+
+void GBuffer::clear(const Coordinate& minimum, const Coordinate& maximum) {
+    for (int y = std::max(minimum.y, 0); y < std::min(maximum.y, _height); ++y) {
+        const auto row = _depth.begin() + static_cast<ptrdiff_t>(y) * _width;
+        std::fill(row + std::max(minimum.x, 0), row + std::min(maximum.x, _width), std::numeric_limits<float>::infinity());
+    }
+}
+
+void GBuffer::draw_triangle(const std::array<Vector3D, 3>& vertices, const Vector3D& normal, const Pixel& albedo) {
+    draw_triangle(vertices, normal, albedo, { 0, 0 }, { _width, _height });
+}
+
+void GBuffer::draw_triangle(const std::array<Vector3D, 3>& vertices, const Vector3D& normal, const Pixel& albedo, const Coordinate& minimum, const Coordinate& maximum) {
+    // Reciprocal view depth is linear in screen space, so it is what gets interpolated
+    std::array<double, 3> inverse_depth;
+    for (size_t i = 0; i < 3; ++i) {
+        const double depth = -vertices[i].w;
+        if (depth <= 0) {
+            return;
+        }
+        inverse_depth[i] = 1 / depth;
+    }
+
+    const auto& [a, b, c] = vertices;
+    const double area = (b.x - a.x) * (c.y - a.y) - (b.y - a.y) * (c.x - a.x);
+    if (area == 0) {
+        return;
+    }
+
+    const int min_x = std::max({ static_cast<int>(std::floor(std::min({ a.x, b.x, c.x }))), minimum.x, 0 });
+    const int min_y = std::max({ static_cast<int>(std::floor(std::min({ a.y, b.y, c.y }))), minimum.y, 0 });
+    const int max_x = std::min({ static_cast<int>(std::ceil(std::max({ a.x, b.x, c.x }))), maximum.x - 1, _width - 1 });
+    const int max_y = std::min({ static_cast<int>(std::ceil(std::max({ a.y, b.y, c.y }))), maximum.y - 1, _height - 1 });
+    if (min_x > max_x or min_y > max_y) {
+        return;
+    }
+
+    // Barycentric weights as edge functions, normalised by the area so either winding is accepted
+    struct Edge {
+        double step_x;
+        double step_y;
+        double row;
+    };
+    std::array<Edge, 3> edges;
+    for (size_t i = 0; i < 3; ++i) {
+        const Vector3D& from = vertices[(i + 1) % 3];
+        const Vector3D& to = vertices[(i + 2) % 3];
+        edges[i].step_x = (from.y - to.y) / area;
+        edges[i].step_y = (to.x - from.x) / area;
+        edges[i].row = edges[i].step_x * (min_x + 0.5 - from.x) + edges[i].step_y * (min_y + 0.5 - from.y);
+    }
+
+    const uint32_t encoded_normal = encode_octahedral(normal);
+
+    uint64_t written = 0;
+    for (int y = min_y; y <= max_y; ++y) {
+        std::array<double, 3> weights = { edges[0].row, edges[1].row, edges[2].row };
+        for (int x = min_x; x <= max_x; ++x) {
+            if (weights[0] >= 0 and weights[1] >= 0 and weights[2] >= 0) {
+                const double depth = 1 / (weights[0] * inverse_depth[0] + weights[1] * inverse_depth[1] + weights[2] * inverse_depth[2]);
+                const size_t index = static_cast<size_t>(y) * _width + x;
+                if (depth < _depth[index]) {
+                    _depth[index] = static_cast<float>(depth);
+                    _normals[index] = encoded_normal;
+                    _albedo[index] = albedo;
+                    ++written;
+                }
+            }
+            for (size_t i = 0; i < 3; ++i) {
+                weights[i] += edges[i].step_x;
+            }
+        }
+        for (auto& edge : edges) {
+            edge.row += edge.step_y;
+        }
+    }
+    Statistics::local().pixels_written += written;
+}
+
+void GBuffer::reproject(const GBuffer& previous, const Matrix4x4& previous_to_current, const Matrix4x4& previous_projection,
+                        const Matrix4x4& projection, const int tile_size, std::vector<uint8_t>& stale_tiles) {
+    if (previous._width != _width or previous._height != _height) {
+        throw std::runtime_error("Can only reproject a G-buffer of the same size");
+    }
+    clear();
+    // 0 uncovered, 1 written by the warp, 2 filled from a neighbour
+    _coverage.assign(_depth.size(), 0);
+
+    // Each pixel's view-space position is depth * (column term + row term); carried into the new view space,
+    // that is depth * (matrix * column term + matrix * row term) plus the translation
+    const auto& m = previous_to_current;
+    const double previous_x_scale = previous_projection[0][0];
+    const double previous_y_scale = previous_projection[1][1];
+    const double x_scale = projection[0][0];
+    const double y_scale = projection[1][1];
+    _columns.resize(_width);
+    for (int x = 0; x < _width; ++x) {
+        const auto ray_x = static_cast<float>(-(2 * (x + 0.5) / _width - 1) / previous_x_scale);
+        _columns[x] = { static_cast<float>(m[0][0] * ray_x), static_cast<float>(m[1][0] * ray_x), static_cast<float>(m[2][0] * ray_x) };
+    }
+    // Pure translation leaves view-space normals as they were
+    const bool rotated = not (m[0][0] == 1 and m[1][1] == 1 and m[2][2] == 1);
+
+    for (int y = 0; y < _height; ++y) {
+        const auto ray_y = static_cast<float>(-(2 * (y + 0.5) / _height - 1) / previous_y_scale);
+        const std::array<float, 3> row = {
+            static_cast<float>(m[0][1] * ray_y + m[0][2]),
+            static_cast<float>(m[1][1] * ray_y + m[1][2]),
+            static_cast<float>(m[2][1] * ray_y + m[2][2])
+        };
+        for (int x = 0; x < _width; ++x) {
+            const size_t source = static_cast<size_t>(y) * _width + x;
+            const float depth = previous._depth[source];
+            const float direction_x = _columns[x][0] + row[0];
+            const float direction_y = _columns[x][1] + row[1];
+            const float direction_z = _columns[x][2] + row[2];
+
+            // Background is at infinity, so it only turns with the camera
+            const bool background = not std::isfinite(depth);
+            const float position_x = background ? direction_x : depth * direction_x + m[0][3];
+            const float position_y = background ? direction_y : depth * direction_y + m[1][3];
+            const float position_z = background ? direction_z : depth * direction_z + m[2][3];
+            if (not (position_z > 0)) {
+                continue;
+            }
+            const double target_x = (-x_scale * position_x / position_z + 1) * _width / 2;
+            const double target_y = (-y_scale * position_y / position_z + 1) * _height / 2;
+            if (not (target_x >= 0 and target_x < _width and target_y >= 0 and target_y < _height)) {
+                continue;
+            }
+            const size_t target = static_cast<size_t>(target_y) * _width + static_cast<size_t>(target_x);
+            const float target_depth = background ? depth : position_z;
+            if (_coverage[target] != 0 and not (target_depth < _depth[target])) {
+                continue;
+            }
+            _coverage[target] = 1;
+            _depth[target] = target_depth;
+            _albedo[target] = previous._albedo[source];
+            _normals[target] = previous._normals[source];
+            if (rotated and not background) {
+                const Vector3D normal = previous.normal(source);
+                _normals[target] = encode_octahedral(m * Vector3D(normal.x, normal.y, normal.z, 0));
+            }
+        }
+    }
+
+    // Resampling leaves cracks where neighbouring pixels spread apart, often with something farther, such as
+    // the background, showing through; take the nearer side across each. Rows are filled first, so that where
+    // a horizontal and a vertical crack cross the vertical pass can close it
+    const auto fill = [&](const size_t target, const size_t a, const size_t b) {
+        if (_coverage[a] == 0 or _coverage[b] == 0) {
+            return;
+        }
+        if (_coverage[target] != 0 and not (std::max(_depth[a], _depth[b]) < _depth[target] * crack_depth_ratio)) {
+            return;
+        }
+        const size_t source = _depth[a] <= _depth[b] ? a : b;
+        _depth[target] = _depth[source];
+        _normals[target] = _normals[source];
+        _albedo[target] = _albedo[source];
+        _coverage[target] = 2;
+    };
+    for (int y = 0; y < _height; ++y) {
+        for (int x = 1; x + 1 < _width; ++x) {
+            const size_t index = static_cast<size_t>(y) * _width + x;
+            fill(index, index - 1, index + 1);
+        }
+    }
+    for (int y = 1; y + 1 < _height; ++y) {
+        for (int x = 0; x < _width; ++x) {
+            const size_t index = static_cast<size_t>(y) * _width + x;
+            fill(index, index - _width, index + _width);
+        }
+    }
+
+    const int across = (_width + tile_size - 1) / tile_size;
+    const int down = (_height + tile_size - 1) / tile_size;
+    stale_tiles.assign(static_cast<size_t>(across) * down, 0);
+    for (int y = 0; y < _height; ++y) {
+        for (int x = 0; x < _width; ++x) {
+            if (_coverage[static_cast<size_t>(y) * _width + x] == 0) {
+                stale_tiles[static_cast<size_t>(y / tile_size) * across + x / tile_size] = 1;
+            }
+        }
+    }
+}
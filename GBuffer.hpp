@@ -0,0 +1,49 @@
+#pragma once
+
+#include "Coordinate.hpp"
+#include "Matrix4x4.hpp"
+#include "Octahedral.hpp"
+#include "Pixel.hpp"
+#include "Vector3D.hpp"
+
+#include <array>
+#include <vector>
+
+
+// Per-pixel surface attributes for deferred shading: linear view-space depth,
+// an octahedron-encoded view-space normal and the surface albedo (12 bytes per pixel)
+class GBuffer {
+public:
+    GBuffer(int width, int height);
+
+    void clear();
+    // Only pixels from minimum up to, but not including, maximum
+    void clear(const Coordinate& minimum, const Coordinate& maximum);
+
+    // Vertices are in screen space with w holding the clip-space w, as produced by Engine3D
+    void draw_triangle(const std::array<Vector3D, 3>& vertices, const Vector3D& normal, const Pixel& albedo);
+    void draw_triangle(const std::array<Vector3D, 3>& vertices, const Vector3D& normal, const Pixel& albedo, const Coordinate& minimum, const Coordinate& maximum);
+
+    // Forward-warps another G-buffer of the same size into this one. previous_to_current carries the other's view
+    // space into this one's, and each projection's diagonal rebuilds and reprojects positions. Gaps a pixel wide
+    // are filled from a neighbour; any pixel still uncovered marks its tile, of tile_size pixels, as stale
+    void reproject(const GBuffer& previous, const Matrix4x4& previous_to_current, const Matrix4x4& previous_projection,
+                   const Matrix4x4& projection, int tile_size, std::vector<uint8_t>& stale_tiles);
+
+    int width() const { return _width; }
+    int height() const { return _height; }
+
+    float depth(const size_t index) const { return _depth[index]; }
+    Vector3D normal(const size_t index) const { return decode_octahedral(_normals[index]); }
+    const Pixel& albedo(const size_t index) const { return _albedo[index]; }
+private:
+    int _width;
+    int _height;
+    std::vector<float> _depth;
+    std::vector<uint32_t> _normals;
+    std::vector<Pixel> _albedo;
+    // Scratch for reproject, kept so that warping a frame does not allocate. Sized on first use; a resize
+    // makes a new G-buffer, which starts without them
+    std::vector<uint8_t> _coverage;
+    std::vector<std::array<float, 3>> _columns;
+};
@@ -0,0 +1,245 @@
+#include "JobSystem.hpp"
+
+#include <fstream>
+#include <stdexcept>
+#include <utility>
+
+#if defined(_WIN32)
+#define NOMINMAX
+#include <windows.h>
+#elif defined(__linux__)
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+
+namespace {
+    // A waiter with nothing to take yields this many times before it sleeps
+    constexpr int spins_before_sleeping = 64;
+
+    // Which system, if any, the current thread belongs to, and its index there
+    thread_local const JobSystem* current_system = nullptr;
+    thread_local unsigned current_index = 0;
+
+    void pin_current_thread(const unsigned processor) {
+#if defined(_WIN32)
+        SetThreadAffinityMask(GetCurrentThread(), DWORD_PTR(1) << (processor % (sizeof(DWORD_PTR) * 8)));
+#elif defined(__linux__)
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        CPU_SET(processor % CPU_SETSIZE, &set);
+        pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+#else
+        static_cast<void>(processor);
+#endif
+    }
+}
+
+
+JobSystem::JobSystem() : JobSystem(Options()) {}
+
+JobSystem::JobSystem(const Options& options) {
+    for (unsigned i = 0; i <= options.worker_count; ++i) {
+        _queues.push_back(std::make_unique<Queue>());
+    }
+    current_system = this;
+    current_index = 0;
+
+    const unsigned processors = std::max(std::thread::hardware_concurrency(), 1u);
+    if (options.pin_threads) {
+        pin_current_thread(0);
+    }
+    for (unsigned i = 1; i <= options.worker_count; ++i) {
+        _workers.emplace_back([this, i, processors, pin = options.pin_threads, start = options.thread_start] {
+            current_system = this;
+            current_index = i;
+            if (pin) {
+                pin_current_thread(i % processors);
+            }
+            if (start) {
+                start(i);
+            }
+            work(i);
+        });
+    }
+}
+
+JobSystem::~JobSystem() {
+    {
+        std::lock_guard lock(_sleep_mutex);
+        _stopping = true;
+    }
+    _wake.notify_all();
+    for (auto& worker : _workers) {
+        worker.join();
+    }
+    if (current_system == this) {
+        current_system = nullptr;
+    }
+}
+
+unsigned JobSystem::current_thread() const {
+    // Threads from outside, such as the mesh loader's, queue onto the owner's deque
+    return current_system == this ? current_index : 0;
+}
+
+void JobSystem::submit(const char* name, std::function<void()> job, JobCounter* counter) {
+    if (counter != nullptr) {
+        counter->_count.fetch_add(1, std::memory_order_relaxed);
+    }
+    Queue& queue = *_queues[current_thread()];
+    {
+        std::lock_guard lock(queue.mutex);
+        queue.jobs.push_back({ name, std::move(job), counter });
+    }
+    _queued.fetch_add(1);
+    // A sleeper either sees the new job when it checks, or is already waiting and gets this notification
+    if (_sleeping.load() > 0) {
+        { std::lock_guard lock(_sleep_mutex); }
+        _wake.notify_one();
+    }
+}
+
+void JobSystem::wait(JobCounter& counter) {
+    // Outsiders help too, so that waiting on a system without workers cannot stall, but are not traced
+    const bool member = current_system == this;
+    Job job;
+    int idle = 0;
+    while (not counter.done()) {
+        if (take(current_thread(), job)) {
+            execute(member ? current_index : no_thread, job);
+            idle = 0;
+        } else if (++idle < spins_before_sleeping) {
+            std::this_thread::yield();
+        } else {
+            // The rest of the counter's jobs are running elsewhere; sleep until one of them queues more or the last finishes
+            std::unique_lock lock(_sleep_mutex);
+            _sleeping.fetch_add(1);
+            _wake.wait(lock, [&] { return counter._count.load() == 0 or _queued.load() > 0; });
+            _sleeping.fetch_sub(1);
+            idle = 0;
+        }
+    }
+    if (counter._failed.load(std::memory_order_acquire)) {
+        const auto error = counter._error;
+        counter._error = nullptr;
+        counter._failed.store(false, std::memory_order_relaxed);
+        std::rethrow_exception(error);
+    }
+    std::exception_ptr error;
+    {
+        std::lock_guard lock(_error_mutex);
+        error = std::exchange(_error, nullptr);
+    }
+    if (error) {
+        std::rethrow_exception(error);
+    }
+}
+
+bool JobSystem::take(const unsigned thread, Job& job) {
+    if (_queued.load(std::memory_order_relaxed) == 0) {
+        return false;
+    }
+    // Newest first from our own deque, since its data is likely still in cache
+    {
+        Queue& own = *_queues[thread];
+        std::lock_guard lock(own.mutex);
+        if (not own.jobs.empty()) {
+            job = std::move(own.jobs.back());
+            own.jobs.pop_back();
+            _queued.fetch_sub(1, std::memory_order_relaxed);
+            return true;
+        }
+    }
+    // Then oldest first from everyone else's, which tends to take the largest remaining pieces
+    for (size_t offset = 1; offset < _queues.size(); ++offset) {
+        Queue& victim = *_queues[(thread + offset) % _queues.size()];
+        std::lock_guard lock(victim.mutex);
+        if (not victim.jobs.empty()) {
+            job = std::move(victim.jobs.front());
+            victim.jobs.pop_front();
+            _queued.fetch_sub(1, std::memory_order_relaxed);
+            return true;
+        }
+    }
+    return false;
+}
+
+void JobSystem::execute(const unsigned thread, Job& job) {
+    const auto start = std::chrono::steady_clock::now();
+    try {
+        job.work();
+    } catch (...) {
+        // With no counter the next wait reports it, whichever counter it waits on
+        if (job.counter == nullptr) {
+            std::lock_guard lock(_error_mutex);
+            if (not _error) {
+                _error = std::current_exception();
+            }
+        } else if (not job.counter->_failed.exchange(true, std::memory_order_acq_rel)) {
+            job.counter->_error = std::current_exception();
+        }
+    }
+    if (thread != no_thread and tracing()) {
+        record(thread, job.name, start);
+    }
+    // A waiter may be asleep on the counter, as in submit
+    if (job.counter != nullptr and job.counter->_count.fetch_sub(1) == 1 and _sleeping.load() > 0) {
+        { std::lock_guard lock(_sleep_mutex); }
+        _wake.notify_all();
+    }
+    job.work = nullptr;
+}
+
+void JobSystem::work(const unsigned thread) {
+    Job job;
+    while (true) {
+        if (take(thread, job)) {
+            execute(thread, job);
+            continue;
+        }
+        std::unique_lock lock(_sleep_mutex);
+        _sleeping.fetch_add(1);
+        _wake.wait(lock, [this] { return _stopping or _queued.load() > 0; });
+        _sleeping.fetch_sub(1);
+        if (_stopping and _queued.load() == 0) {
+            return;
+        }
+    }
+}
+
+void JobSystem::record(const unsigned thread, const char* name, const std::chrono::steady_clock::time_point start) {
+    _queues[thread]->trace.push_back({ name, start, std::chrono::steady_clock::now() });
+}
+
+void JobSystem::write_trace(const std::string& path) const {
+    std::ofstream file(path);
+    if (not file) {
+        throw std::runtime_error("Could not open trace file " + path);
+    }
+    const auto microseconds = [this](const std::chrono::steady_clock::time_point time) {
+        return std::chrono::duration<double, std::micro>(time - _epoch).count();
+    };
+
+    file << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+    for (unsigned thread = 0; thread < _queues.size(); ++thread) {
+        file << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << thread
+             << ",\"args\":{\"name\":\"" << (thread == 0 ? std::string("Main") : "Worker " + std::to_string(thread)) << "\"}}";
+        for (const auto& event : _queues[thread]->trace) {
+            file << ",\n{\"name\":\"" << event.name << "\",\"ph\":\"X\",\"pid\":1,\"tid\":" << thread
+                 << ",\"ts\":" << microseconds(event.start) << ",\"dur\":" << microseconds(event.end) - microseconds(event.start) << '}';
+        }
+        file << (thread + 1 < _queues.size() ? ",\n" : "\n");
+    }
+    file << "]}\n";
+}
+
+
+JobSystem::TraceScope::TraceScope(JobSystem& jobs, const char* name) :
+    _jobs(jobs), _name(name), _start(std::chrono::steady_clock::now()) {}
+
+JobSystem::TraceScope::~TraceScope() {
+    if (_jobs.tracing() and current_system == &_jobs) {
+        _jobs.record(current_index, _name, _start);
+    }
+}
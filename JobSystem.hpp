@@ -0,0 +1,127 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+
+// Counts a group of outstanding jobs. The first exception a job throws is kept and rethrown by JobSystem::wait
+class JobCounter {
+public:
+    bool done() const { return _count.load(std::memory_order_acquire) == 0; }
+private:
+    friend class JobSystem;
+    std::atomic<size_t> _count = 0;
+    std::atomic<bool> _failed = false;
+    std::exception_ptr _error;
+};
+
+
+// Work-stealing scheduler. Every thread owns a deque: it pushes and pops its own jobs at the back,
+// while idle threads steal the oldest jobs from the front of others'. The thread that creates the
+// system takes part as thread 0 whenever it waits
+class JobSystem {
+public:
+    struct Options {
+        // Threads besides the owner
+        unsigned worker_count = std::max(std::thread::hardware_concurrency(), 1u) - 1;
+        // Binds thread i to logical processor i
+        bool pin_threads = false;
+        // Runs first on every worker thread, given its index
+        std::function<void(unsigned thread)> thread_start;
+    };
+
+    JobSystem();
+    explicit JobSystem(const Options&);
+    ~JobSystem();
+    JobSystem(const JobSystem&) = delete;
+    JobSystem& operator=(const JobSystem&) = delete;
+
+    // name must outlive the system; it labels the job in traces. The first exception thrown by a job
+    // without a counter is kept and rethrown by the next wait
+    void submit(const char* name, std::function<void()> job, JobCounter* = nullptr);
+    // Runs queued jobs on the calling thread until the counter reaches zero, sleeping once there are none to take
+    void wait(JobCounter&);
+    // Runs body(begin, end) over [0, count) in ranges of at most grain, and returns once all have finished
+    template <typename Function>
+    void parallel_for(const char* name, size_t count, size_t grain, Function&& body);
+
+    unsigned thread_count() const { return static_cast<unsigned>(_queues.size()); }
+
+    // Records every job, and any TraceScope, for write_trace
+    void set_tracing(bool tracing) { _tracing.store(tracing, std::memory_order_relaxed); }
+    bool tracing() const { return _tracing.load(std::memory_order_relaxed); }
+    // Chrome trace event JSON, for chrome://tracing or Perfetto
+    void write_trace(const std::string& path) const;
+
+    // Traces a stretch of work on the calling thread that does not run as a job
+    class TraceScope {
+    public:
+        TraceScope(JobSystem&, const char* name);
+        ~TraceScope();
+        TraceScope(const TraceScope&) = delete;
+        TraceScope& operator=(const TraceScope&) = delete;
+    private:
+        JobSystem& _jobs;
+        const char* _name;
+        std::chrono::steady_clock::time_point _start;
+    };
+private:
+    struct Job {
+        const char* name;
+        std::function<void()> work;
+        JobCounter* counter;
+    };
+    struct TraceEvent {
+        const char* name;
+        std::chrono::steady_clock::time_point start;
+        std::chrono::steady_clock::time_point end;
+    };
+    struct alignas(64) Queue {
+        std::mutex mutex;
+        std::deque<Job> jobs;
+        // Only touched by the queue's own thread
+        std::vector<TraceEvent> trace;
+    };
+
+    static constexpr unsigned no_thread = ~0u;
+
+    unsigned current_thread() const;
+    bool take(unsigned thread, Job&);
+    void execute(unsigned thread, Job&);
+    void work(unsigned thread);
+    void record(unsigned thread, const char* name, std::chrono::steady_clock::time_point start);
+
+    std::vector<std::unique_ptr<Queue>> _queues;
+    std::vector<std::thread> _workers;
+    std::atomic<size_t> _queued = 0;
+    std::atomic<unsigned> _sleeping = 0;
+    std::atomic<bool> _tracing = false;
+    bool _stopping = false;
+    std::mutex _error_mutex;
+    std::exception_ptr _error;
+    std::mutex _sleep_mutex;
+    std::condition_variable _wake;
+    const std::chrono::steady_clock::time_point _epoch = std::chrono::steady_clock::now();
+};
+
+
+template <typename Function>
+void JobSystem::parallel_for(const char* name, const size_t count, size_t grain, Function&& body) {
+    grain = std::max<size_t>(grain, 1);
+    JobCounter counter;
+    for (size_t begin = 0; begin < count; begin += grain) {
+        const size_t end = std::min(begin + grain, count);
+        submit(name, [&body, begin, end] { body(begin, end); }, &counter);
+    }
+    wait(counter);
+}
@@ -0,0 +1,16 @@
+#pragma once
+
+#include "Vector3D.hpp"
+
+
+struct PointLight {
+    Vector3D position;
+    Vector3D colour = { 1, 1, 1 };
+    double radius = 5;
+};
+
+
+struct DirectionalLight {
+    Vector3D direction = { 0, 0, -1 };
+    Vector3D colour = { 1, 1, 1 };
+};
@@ -1,19 +1,23 @@
 #pragma once
 
 #include "Coordinate.hpp"
+#include "SimdKernels.hpp"
 #include "Vector3D.hpp"
 
 #include <iomanip>
+#include <span>
+#include <type_traits>
 
 
-struct Matrix4x4 {
-    std::array<double, 4>& operator[](size_t index) { return _elements[index]; }
-    const std::array<double, 4>& operator[](size_t index) const { return _elements[index]; }
+template <typename T>
+struct BasicMatrix4x4 {
+    std::array<T, 4>& operator[](size_t index) { return _elements[index]; }
+    const std::array<T, 4>& operator[](size_t index) const { return _elements[index]; }
 
-    Matrix4x4() = default;
-    Matrix4x4(const Matrix4x4&) = default;
-    explicit Matrix4x4(const std::array<std::array<double, 4>, 4>& elements) : _elements(elements) {}
-    Matrix4x4(const std::initializer_list<std::initializer_list<double>>& elements) {
+    BasicMatrix4x4() = default;
+    BasicMatrix4x4(const BasicMatrix4x4&) = default;
+    explicit BasicMatrix4x4(const std::array<std::array<T, 4>, 4>& elements) : _elements(elements) {}
+    BasicMatrix4x4(const std::initializer_list<std::initializer_list<T>>& elements) {
         size_t r = 0;
         for (const auto& row : elements) {
             size_t c = 0;
@@ -25,9 +29,10 @@ struct Matrix4x4 {
         }
     }
 
-    Matrix4x4& operator=(const Matrix4x4&) = default;
-    inline Matrix4x4 operator-() const {
-        Matrix4x4 result = *this;
+    BasicMatrix4x4& operator=(const BasicMatrix4x4&) = default;
+    bool operator==(const BasicMatrix4x4&) const = default;
+    inline BasicMatrix4x4 operator-() const {
+        BasicMatrix4x4 result = *this;
         for (auto& row : result._elements) {
             for (auto& element : row) {
                 element = -element;
@@ -37,21 +42,21 @@ struct Matrix4x4 {
     }
 
 
-    Matrix4x4& operator+=(const Matrix4x4&);
-    Matrix4x4& operator-=(const Matrix4x4&);
-    Matrix4x4& operator*=(const Matrix4x4&);
+    BasicMatrix4x4& operator+=(const BasicMatrix4x4&);
+    BasicMatrix4x4& operator-=(const BasicMatrix4x4&);
+    BasicMatrix4x4& operator*=(const BasicMatrix4x4&);
 
-    Matrix4x4& operator*=(double);
-    Matrix4x4& operator/=(double);
+    BasicMatrix4x4& operator*=(std::type_identity_t<T>);
+    BasicMatrix4x4& operator/=(std::type_identity_t<T>);
 
-    Matrix4x4& operator++();
-    Matrix4x4& operator--();
+    BasicMatrix4x4& operator++();
+    BasicMatrix4x4& operator--();
 
-    Matrix4x4 operator++(int);
-    Matrix4x4 operator--(int);
+    BasicMatrix4x4 operator++(int);
+    BasicMatrix4x4 operator--(int);
 
-    Matrix4x4 transpose() const {
-        Matrix4x4 result;
+    BasicMatrix4x4 transpose() const {
+        BasicMatrix4x4 result;
         for (size_t row = 0; row < 4; ++row) {
             for (size_t column = 0; column < 4; ++column) {
                 result[row][column] = _elements[column][row];
@@ -59,8 +64,8 @@ struct Matrix4x4 {
         }
         return result;
     }
-    Matrix4x4 sub_matrix(const size_t row, const size_t column) const {
-        Matrix4x4 result;
+    BasicMatrix4x4 sub_matrix(const size_t row, const size_t column) const {
+        BasicMatrix4x4 result;
         size_t i = 0;
         for (size_t r = 0; r < 4; ++r) {
             if (r == row) continue;
@@ -74,21 +79,24 @@ struct Matrix4x4 {
         }
         return result;
     }
-    double determinant() const {
-        double result = 0;
+    T determinant() const {
+        T result = 0;
         for (size_t i = 0; i < 4; ++i) {
             result += (i % 2 == 0 ? 1 : -1) * _elements[0][i] * sub_matrix(0, i).determinant();
         }
         return result;
     }
-    Matrix4x4 inverse() const;
+    BasicMatrix4x4 inverse() const;
 private:
-    std::array<std::array<double, 4>, 4> _elements;
+    alignas(16) std::array<std::array<T, 4>, 4> _elements;
 };
 
+using Matrix4x4 = BasicMatrix4x4<Scalar>;
 
-inline Matrix4x4 operator+(const Matrix4x4& lhs, const Matrix4x4& rhs) {
-    Matrix4x4 result;
+
+template <typename T>
+inline BasicMatrix4x4<T> operator+(const BasicMatrix4x4<T>& lhs, const BasicMatrix4x4<T>& rhs) {
+    BasicMatrix4x4<T> result;
     for (size_t row = 0; row < 4; ++row) {
         for (size_t column = 0; column < 4; ++column) {
             result[row][column] = lhs[row][column] + rhs[row][column];
@@ -96,8 +104,9 @@ inline Matrix4x4 operator+(const Matrix4x4& lhs, const Matrix4x4& rhs) {
     }
     return result;
 }
-inline Matrix4x4 operator-(const Matrix4x4& lhs, const Matrix4x4& rhs) {
-    Matrix4x4 result;
+template <typename T>
+inline BasicMatrix4x4<T> operator-(const BasicMatrix4x4<T>& lhs, const BasicMatrix4x4<T>& rhs) {
+    BasicMatrix4x4<T> result;
     for (size_t row = 0; row < 4; ++row) {
         for (size_t column = 0; column < 4; ++column) {
             result[row][column] = lhs[row][column] - rhs[row][column];
@@ -105,8 +114,22 @@ inline Matrix4x4 operator-(const Matrix4x4& lhs, const Matrix4x4& rhs) {
     }
     return result;
 }
-inline Matrix4x4 operator*(const Matrix4x4& lhs, const Matrix4x4& rhs) {
-    Matrix4x4 result;
+template <typename T>
+inline BasicMatrix4x4<T> operator*(const BasicMatrix4x4<T>& lhs, const BasicMatrix4x4<T>& rhs) {
+    BasicMatrix4x4<T> result;
+#ifdef RENDERER_SSE
+    if constexpr (std::is_same_v<T, float>) {
+        // Each result row is the rows of rhs weighted by one row of lhs
+        for (size_t row = 0; row < 4; ++row) {
+            __m128 sum = _mm_mul_ps(_mm_set1_ps(lhs[row][0]), _mm_load_ps(rhs[0].data()));
+            for (size_t i = 1; i < 4; ++i) {
+                sum = _mm_add_ps(sum, _mm_mul_ps(_mm_set1_ps(lhs[row][i]), _mm_load_ps(rhs[i].data())));
+            }
+            _mm_store_ps(result[row].data(), sum);
+        }
+        return result;
+    }
+#endif
     for (size_t row = 0; row < 4; ++row) {
         for (size_t column = 0; column < 4; ++column) {
             result[row][column] = 0;
@@ -118,12 +141,16 @@ inline Matrix4x4 operator*(const Matrix4x4& lhs, const Matrix4x4& rhs) {
     return result;
 }
 
-inline Matrix4x4& Matrix4x4::operator+=(const Matrix4x4& other) { return *this = *this + other; }
-inline Matrix4x4& Matrix4x4::operator-=(const Matrix4x4& other) { return *this = *this - other; }
-inline Matrix4x4& Matrix4x4::operator*=(const Matrix4x4& other) { return *this = other * *this; }
+template <typename T>
+inline BasicMatrix4x4<T>& BasicMatrix4x4<T>::operator+=(const BasicMatrix4x4<T>& other) { return *this = *this + other; }
+template <typename T>
+inline BasicMatrix4x4<T>& BasicMatrix4x4<T>::operator-=(const BasicMatrix4x4<T>& other) { return *this = *this - other; }
+template <typename T>
+inline BasicMatrix4x4<T>& BasicMatrix4x4<T>::operator*=(const BasicMatrix4x4<T>& other) { return *this = other * *this; }
 
-inline Matrix4x4 operator*(const Matrix4x4& matrix, const double scalar) {
-    Matrix4x4 result = matrix;
+template <typename T>
+inline BasicMatrix4x4<T> operator*(const BasicMatrix4x4<T>& matrix, const std::type_identity_t<T> scalar) {
+    BasicMatrix4x4<T> result = matrix;
     for (size_t row = 0; row < 4; ++row) {
         for (size_t column = 0; column < 4; ++column) {
             result[row][column] *= scalar;
@@ -131,9 +158,11 @@ inline Matrix4x4 operator*(const Matrix4x4& matrix, const double scalar) {
     }
     return result;
 }
-inline Matrix4x4 operator*(const double scalar, const Matrix4x4& matrix) { return matrix * scalar; }
-inline Matrix4x4 operator/(const Matrix4x4& matrix, const double scalar) {
-    Matrix4x4 result = matrix;
+template <typename T>
+inline BasicMatrix4x4<T> operator*(const std::type_identity_t<T> scalar, const BasicMatrix4x4<T>& matrix) { return matrix * scalar; }
+template <typename T>
+inline BasicMatrix4x4<T> operator/(const BasicMatrix4x4<T>& matrix, const std::type_identity_t<T> scalar) {
+    BasicMatrix4x4<T> result = matrix;
     for (size_t row = 0; row < 4; ++row) {
         for (size_t column = 0; column < 4; ++column) {
             result[row][column] /= scalar;
@@ -142,9 +171,10 @@ inline Matrix4x4 operator/(const Matrix4x4& matrix, const double scalar) {
     return result;
 }
 
-inline Matrix4x4 Matrix4x4::inverse() const {
-    Matrix4x4 result;
-    double determinant = 0;
+template <typename T>
+inline BasicMatrix4x4<T> BasicMatrix4x4<T>::inverse() const {
+    BasicMatrix4x4<T> result;
+    T determinant = 0;
     for (size_t i = 0; i < 4; ++i) {
         determinant += (i % 2 == 0 ? 1 : -1) * _elements[0][i] * sub_matrix(0, i).determinant();
     }
@@ -157,10 +187,24 @@ inline Matrix4x4 Matrix4x4::inverse() const {
     return result.transpose() / determinant;
 }
 
-inline Matrix4x4& Matrix4x4::operator*=(const double scalar) { return *this = *this * scalar; }
-inline Matrix4x4& Matrix4x4::operator/=(const double scalar) { return *this = *this / scalar; }
-
-inline Vector3D operator*(const Matrix4x4& matrix, const Vector3D& vector) {
+template <typename T>
+inline BasicMatrix4x4<T>& BasicMatrix4x4<T>::operator*=(const std::type_identity_t<T> scalar) { return *this = *this * scalar; }
+template <typename T>
+inline BasicMatrix4x4<T>& BasicMatrix4x4<T>::operator/=(const std::type_identity_t<T> scalar) { return *this = *this / scalar; }
+
+template <typename T>
+inline BasicVector3D<T> operator*(const BasicMatrix4x4<T>& matrix, const BasicVector3D<T>& vector) {
+#ifdef RENDERER_SSE
+    if constexpr (std::is_same_v<T, float>) {
+        const __m128 v = load(vector);
+        __m128 x = _mm_mul_ps(_mm_load_ps(matrix[0].data()), v);
+        __m128 y = _mm_mul_ps(_mm_load_ps(matrix[1].data()), v);
+        __m128 z = _mm_mul_ps(_mm_load_ps(matrix[2].data()), v);
+        __m128 w = _mm_mul_ps(_mm_load_ps(matrix[3].data()), v);
+        _MM_TRANSPOSE4_PS(x, y, z, w);
+        return store(_mm_add_ps(_mm_add_ps(x, y), _mm_add_ps(z, w)));
+    }
+#endif
     return {
         matrix[0][0] * vector.x + matrix[0][1] * vector.y + matrix[0][2] * vector.z + matrix[0][3] * vector.w,
         matrix[1][0] * vector.x + matrix[1][1] * vector.y + matrix[1][2] * vector.z + matrix[1][3] * vector.w,
@@ -168,11 +212,26 @@ inline Vector3D operator*(const Matrix4x4& matrix, const Vector3D& vector) {
         matrix[3][0] * vector.x + matrix[3][1] * vector.y + matrix[3][2] * vector.z + matrix[3][3] * vector.w
     };
 };
-inline Vector3D operator*(const Vector3D& vector, const Matrix4x4& matrix) { return matrix * vector; }
+template <typename T>
+inline BasicVector3D<T> operator*(const BasicVector3D<T>& vector, const BasicMatrix4x4<T>& matrix) { return matrix * vector; }
+
+// Transforms points in bulk with the widest vector unit the processor offers; points and transformed may be the same
+template <typename T>
+inline void transform_points(const BasicMatrix4x4<T>& matrix, const std::span<const BasicVector3D<T>> points, const std::span<BasicVector3D<T>> transformed) {
+    if constexpr (std::is_same_v<T, float>) {
+        SimdKernels::active().transform(matrix[0].data(), &points.data()->x, &transformed.data()->x, points.size());
+    } else {
+        for (size_t i = 0; i < points.size(); ++i) {
+            transformed[i] = matrix * points[i];
+        }
+    }
+}
 
-inline Vector3D& operator*=(Vector3D& vector, const Matrix4x4& matrix) { return vector = matrix * vector; }
+template <typename T>
+inline BasicVector3D<T>& operator*=(BasicVector3D<T>& vector, const BasicMatrix4x4<T>& matrix) { return vector = matrix * vector; }
 
-inline Matrix4x4 make_identity_matrix() {
+template <typename T = Scalar>
+inline BasicMatrix4x4<T> make_identity_matrix() {
     return {
         { 1, 0, 0, 0 },
         { 0, 1, 0, 0 },
@@ -181,13 +240,17 @@ inline Matrix4x4 make_identity_matrix() {
     };
 }
 
-inline Matrix4x4& Matrix4x4::operator++() { return *this += make_identity_matrix(); }
-inline Matrix4x4& Matrix4x4::operator--() { return *this -= make_identity_matrix(); }
+template <typename T>
+inline BasicMatrix4x4<T>& BasicMatrix4x4<T>::operator++() { return *this += make_identity_matrix<T>(); }
+template <typename T>
+inline BasicMatrix4x4<T>& BasicMatrix4x4<T>::operator--() { return *this -= make_identity_matrix<T>(); }
 
-inline Matrix4x4 Matrix4x4::operator++(int) { const Matrix4x4 result = *this; ++*this; return result; }
-inline Matrix4x4 Matrix4x4::operator--(int) { const Matrix4x4 result = *this; --*this; return result; }
+template <typename T>
+inline BasicMatrix4x4<T> BasicMatrix4x4<T>::operator++(int) { const BasicMatrix4x4 result = *this; ++*this; return result; }
+template <typename T>
+inline BasicMatrix4x4<T> BasicMatrix4x4<T>::operator--(int) { const BasicMatrix4x4 result = *this; --*this; return result; }
 
-inline Matrix4x4 make_translation_matrix(const double x, const double y, const double z) {
+inline Matrix4x4 make_translation_matrix(const Scalar x, const Scalar y, const Scalar z) {
     return {
         { 1, 0, 0, x },
         { 0, 1, 0, y },
@@ -197,7 +260,7 @@ inline Matrix4x4 make_translation_matrix(const double x, const double y, const d
 }
 inline Matrix4x4 make_translation_matrix(const Vector3D& axes) { return make_translation_matrix(axes.x, axes.y, axes.z); }
 
-inline Matrix4x4 make_scaling_matrix(const double x, const double y, const double z) {
+inline Matrix4x4 make_scaling_matrix(const Scalar x, const Scalar y, const Scalar z) {
     return {
         { x, 0, 0, 0 },
         { 0, y, 0, 0 },
@@ -207,7 +270,7 @@ inline Matrix4x4 make_scaling_matrix(const double x, const double y, const doubl
 }
 inline Matrix4x4 make_scaling_matrix(const Vector3D& axes) { return make_scaling_matrix(axes.x, axes.y, axes.z); }
 
-inline Matrix4x4 make_rotation_matrix_x(const double angle_radians) {
+inline Matrix4x4 make_rotation_matrix_x(const Scalar angle_radians) {
     return {
         { 1, 0,                       0,                        0 },
         { 0, std::cos(angle_radians), -std::sin(angle_radians), 0 },
@@ -215,7 +278,7 @@ inline Matrix4x4 make_rotation_matrix_x(const double angle_radians) {
         { 0, 0,                       0,                        1 }
     };
 }
-inline Matrix4x4 make_rotation_matrix_y(const double angle_radians) {
+inline Matrix4x4 make_rotation_matrix_y(const Scalar angle_radians) {
     return {
         { std::cos(angle_radians),  0, std::sin(angle_radians), 0 },
         { 0,                        1, 0,                       0 },
@@ -223,7 +286,7 @@ inline Matrix4x4 make_rotation_matrix_y(const double angle_radians) {
         { 0,                        0, 0,                       1 }
     };
 }
-inline Matrix4x4 make_rotation_matrix_z(const double angle_radians) {
+inline Matrix4x4 make_rotation_matrix_z(const Scalar angle_radians) {
     return {
         { std::cos(angle_radians), -std::sin(angle_radians), 0, 0 },
         { std::sin(angle_radians), std::cos(angle_radians),  0, 0 },
@@ -232,7 +295,7 @@ inline Matrix4x4 make_rotation_matrix_z(const double angle_radians) {
     };
 }
 
-inline Matrix4x4 make_rotation_matrix(const double x, const double y, const double z) {
+inline Matrix4x4 make_rotation_matrix(const Scalar x, const Scalar y, const Scalar z) {
     return {
         { std::cos(x) * std::cos(y), std::cos(x) * std::sin(y) * std::sin(z) - std::sin(x) * std::cos(z), std::cos(x) * std::sin(y) * std::cos(z) + std::sin(x) * std::sin(z), 0 },
         { std::sin(x) * std::cos(y), std::sin(x) * std::sin(y) * std::sin(z) + std::cos(x) * std::cos(z), std::sin(x) * std::sin(y) * std::cos(z) - std::cos(x) * std::sin(z), 0 },
@@ -244,14 +307,14 @@ inline Matrix4x4 make_rotation_matrix(const Vector3D& angles_radians) {
     return make_rotation_matrix(angles_radians.x, angles_radians.y, angles_radians.z);
 }
 
-inline Matrix4x4 make_projection_matrix(const Coordinate& screen_dimensions, const double fov_degrees, const double z_near, const double z_far) {
-    const double aspect_ratio = static_cast<double>(screen_dimensions.x) / static_cast<double>(screen_dimensions.y);
-    const double fov_radians = fov_degrees * 3.14159265358979323846 / 180;
-    const double y_scale = 1 / std::tan(fov_radians / 2);
-    const double x_scale = y_scale / aspect_ratio;
-    const double z_range = z_far - z_near;
-    const double z_scale = z_far / z_range;
-    const double z_translation = -z_near * z_scale;
+inline Matrix4x4 make_projection_matrix(const Coordinate& screen_dimensions, const Scalar fov_degrees, const Scalar z_near, const Scalar z_far) {
+    const Scalar aspect_ratio = static_cast<Scalar>(screen_dimensions.x) / static_cast<Scalar>(screen_dimensions.y);
+    const Scalar fov_radians = fov_degrees * static_cast<Scalar>(3.14159265358979323846 / 180);
+    const Scalar y_scale = 1 / std::tan(fov_radians / 2);
+    const Scalar x_scale = y_scale / aspect_ratio;
+    const Scalar z_range = z_far - z_near;
+    const Scalar z_scale = z_far / z_range;
+    const Scalar z_translation = -z_near * z_scale;
     return {
         { x_scale, 0,     0,       0           },
         { 0,     y_scale, 0,       0           },
@@ -260,10 +323,19 @@ inline Matrix4x4 make_projection_matrix(const Coordinate& screen_dimensions, con
     };
 }
 
+inline Matrix4x4 make_orthographic_matrix(const Scalar left, const Scalar right, const Scalar bottom, const Scalar top, const Scalar z_near, const Scalar z_far) {
+    return {
+        { 2 / (right - left), 0,                  0,                      -(right + left) / (right - left) },
+        { 0,                  2 / (top - bottom), 0,                      -(top + bottom) / (top - bottom) },
+        { 0,                  0,                  1 / (z_far - z_near),   -z_near / (z_far - z_near)       },
+        { 0,                  0,                  0,                      1                                }
+    };
+}
+
 inline Matrix4x4 make_camera_matrix(const Vector3D& position, const Vector3D& target, const Vector3D& up = { 0, 1, 0 }) {
-    const Vector3D& new_forward = (target - position).normalise();
-    const Vector3D& new_up = (up - new_forward * dot(up, new_forward)).normalise();
-    const Vector3D& new_right = cross(new_forward, new_up);
+    const Vector3D new_forward = (target - position).normalise();
+    const Vector3D new_up = (up - new_forward * dot(up, new_forward)).normalise();
+    const Vector3D new_right = cross(new_forward, new_up);
     return {
         { new_right.x, new_up.x, new_forward.x, position.x },
         { new_right.y, new_up.y, new_forward.y, position.y },
@@ -277,14 +349,14 @@ inline Matrix4x4 quick_inverse(const Matrix4x4& matrix) {
         { matrix[0][0], matrix[1][0], matrix[2][0], 0 },
         { matrix[0][1], matrix[1][1], matrix[2][1], 0 },
         { matrix[0][2], matrix[1][2], matrix[2][2], 0 },
-        { -dot(matrix[0], matrix[3]), -dot(matrix[1], matrix[3]), -dot(matrix[2], matrix[3]), 1  }
+        { -dot(Vector3D(matrix[0]), Vector3D(matrix[3])), -dot(Vector3D(matrix[1]), Vector3D(matrix[3])), -dot(Vector3D(matrix[2]), Vector3D(matrix[3])), 1  }
     };
 }
 
 inline Matrix4x4 make_view_matrix(const Vector3D& position, const Vector3D& target, const Vector3D& up = { 0, 1, 0 }) {
-    const Vector3D& new_forward = (target - position).normalise();
-    const Vector3D& new_up = (up - new_forward * dot(up, new_forward)).normalise();
-    const Vector3D& new_right = cross(new_forward, new_up);
+    const Vector3D new_forward = (target - position).normalise();
+    const Vector3D new_up = (up - new_forward * dot(up, new_forward)).normalise();
+    const Vector3D new_right = cross(new_forward, new_up);
     return {
         { new_right.x,   new_right.y,   new_right.z,   -dot(position, new_right)   },
         { new_up.x,      new_up.y,      new_up.z,      -dot(position, new_up)      },
@@ -293,7 +365,8 @@ inline Matrix4x4 make_view_matrix(const Vector3D& position, const Vector3D& targ
     };
 }
 
-inline std::ostream& operator<<(std::ostream& stream, const Matrix4x4& matrix) {
+template <typename T>
+inline std::ostream& operator<<(std::ostream& stream, const BasicMatrix4x4<T>& matrix) {
     for (size_t row = 0; row < 4; ++row) {
         stream << "[ ";
         for (size_t column = 0; column < 4; ++column) {
@@ -304,8 +377,6 @@ inline std::ostream& operator<<(std::ostream& stream, const Matrix4x4& matrix) {
     return stream;
 }
 
-//inline bool operator==(const Matrix4x4&, const Matrix4x4&);
-//inline bool operator!=(const Matrix4x4&, const Matrix4x4&);
 //inline bool operator<(const Matrix4x4&, const Matrix4x4&);
 //inline bool operator>(const Matrix4x4&, const Matrix4x4&);
 //inline bool operator<=(const Matrix4x4&, const Matrix4x4&);
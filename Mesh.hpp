@@ -4,6 +4,8 @@
 
 #include "Matrix4x4.hpp"
 
+#include <algorithm>
+#include <functional>
 #include <string>
 #include <fstream>
 #include <stdexcept>
@@ -12,17 +14,20 @@
 
 struct Mesh {
     std::vector<Triangle> triangles;
+    // The indexed form the triangles were built from, kept for preprocessing
+    std::vector<Vector3D> vertices;
+    std::vector<uint32_t> indices;
 
     Mesh() = default;
 
-    Mesh(const std::string& filename) {
+    // on_vertices is handed a bounding-box stand-in once the vertex list has been read, before the faces are.
+    // An indexed_only mesh keeps just vertices and indices, for callers that never draw it directly
+    Mesh(const std::string& filename, const std::function<void(Mesh)>& on_vertices = nullptr, const bool indexed_only = false) {
         std::ifstream file_stream(filename);
         if (not file_stream.is_open()) {
             throw std::runtime_error("Could not open file " + filename);
         }
 
-        std::vector<Vector3D> vertices;
-
         size_t line_number = 1;
 
         while (not file_stream.eof()) {
@@ -34,7 +39,7 @@ struct Mesh {
             line_stream >> type;
 
             if (type == 'v') {
-                std::array<double, 3> vertex;
+                std::array<Scalar, 3> vertex;
 
                 for (auto& coordinate : vertex) {
                     if (line_stream.eof()) {
@@ -50,6 +55,10 @@ struct Mesh {
             }
 
             else if (type == 'f') {
+                if (on_vertices and indices.empty()) {
+                    on_vertices(make_bounding_box(vertices));
+                }
+
                 Triangle triangle;
 
                 for (auto& vertex : triangle.vertices) {
@@ -61,10 +70,16 @@ struct Mesh {
                     if (index + '0' == '#') {
                         throw std::runtime_error("Line " + std::to_string(line_number) + ": Face must have 3 indices");
                     }
+                    if (index == 0 or index > vertices.size()) {
+                        throw std::runtime_error("Line " + std::to_string(line_number) + ": Vertex index out of range");
+                    }
                     vertex = vertices[index - 1];
+                    indices.push_back(static_cast<uint32_t>(index - 1));
                 }
 
-                triangles.push_back(triangle);
+                if (not indexed_only) {
+                    triangles.push_back(triangle);
+                }
             }
 
             else if (type != '#' and type != '\0' and type != 's') {
@@ -75,6 +90,44 @@ struct Mesh {
         }
     }
 
+    void rebuild_triangles() {
+        triangles.resize(indices.size() / 3);
+        for (size_t i = 0; i < triangles.size(); ++i) {
+            triangles[i] = { vertices[indices[3 * i]], vertices[indices[3 * i + 1]], vertices[indices[3 * i + 2]] };
+        }
+    }
+
+    static Mesh make_box(const Vector3D& minimum, const Vector3D& maximum) {
+        std::array<Vector3D, 8> corners;
+        for (size_t i = 0; i < corners.size(); ++i) {
+            corners[i] = { i & 1 ? maximum.x : minimum.x, i & 2 ? maximum.y : minimum.y, i & 4 ? maximum.z : minimum.z };
+        }
+        // Wound so every face normal points outwards
+        constexpr std::array<std::array<size_t, 3>, 12> faces = { {
+            { 0, 4, 6 }, { 0, 6, 2 }, { 1, 3, 7 }, { 1, 7, 5 },
+            { 0, 1, 5 }, { 0, 5, 4 }, { 2, 6, 7 }, { 2, 7, 3 },
+            { 0, 2, 3 }, { 0, 3, 1 }, { 4, 5, 7 }, { 4, 7, 6 }
+        } };
+        Mesh box;
+        for (const auto& [a, b, c] : faces) {
+            box.triangles.push_back({ corners[a], corners[b], corners[c] });
+        }
+        return box;
+    }
+
+    static Mesh make_bounding_box(const std::vector<Vector3D>& vertices) {
+        if (vertices.empty()) {
+            return {};
+        }
+        Vector3D minimum = vertices.front();
+        Vector3D maximum = vertices.front();
+        for (const auto& vertex : vertices) {
+            minimum = { std::min(minimum.x, vertex.x), std::min(minimum.y, vertex.y), std::min(minimum.z, vertex.z) };
+            maximum = { std::max(maximum.x, vertex.x), std::max(maximum.y, vertex.y), std::max(maximum.z, vertex.z) };
+        }
+        return make_box(minimum, maximum);
+    }
+
     void transform(const Matrix4x4& matrix) {
         for (auto& triangle : triangles) {
             triangle.transform(matrix);
@@ -0,0 +1,133 @@
+#include "MeshLoader.hpp"
+
+#include <stdexcept>
+
+
+MeshHandle::State MeshHandle::state() const {
+    return _shared->state.load(std::memory_order_acquire);
+}
+
+const Mesh* MeshHandle::mesh() const {
+    switch (state()) {
+        case State::Placeholder: return &_shared->placeholder;
+        case State::Ready: return _shared->quantised_mesh ? nullptr : &_shared->mesh;
+        case State::Failed: std::rethrow_exception(_shared->error);
+        default: return nullptr;
+    }
+}
+
+const QuantisedMesh* MeshHandle::quantised_mesh() const {
+    if (state() != State::Ready or not _shared->quantised_mesh) {
+        return nullptr;
+    }
+    return &*_shared->quantised_mesh;
+}
+
+const MeshOptimisationReport* MeshHandle::optimisation_report() const {
+    if (state() != State::Ready or not _shared->optimisation_report) {
+        return nullptr;
+    }
+    return &*_shared->optimisation_report;
+}
+
+void MeshHandle::wait() const {
+    std::unique_lock lock(_shared->mutex);
+    _shared->finished.wait(lock, [this] { return state() == State::Ready or state() == State::Failed; });
+    if (state() == State::Failed) {
+        std::rethrow_exception(_shared->error);
+    }
+}
+
+const std::string& MeshHandle::filename() const {
+    return _shared->filename;
+}
+
+
+MeshLoader::MeshLoader(const unsigned worker_count) : _worker_count(std::max(worker_count, 1u)) {}
+
+MeshLoader::~MeshLoader() {
+    {
+        std::lock_guard lock(_mutex);
+        _stopping = true;
+    }
+    _job_queued.notify_all();
+    for (auto& worker : _workers) {
+        worker.join();
+    }
+    // Loads that never started fail, so that no handle waits on them forever
+    for (const auto& job : _queue) {
+        job->error = std::make_exception_ptr(std::runtime_error("Mesh loader stopped before loading " + job->filename));
+        finish(*job, MeshHandle::State::Failed);
+    }
+}
+
+MeshHandle MeshLoader::load(const std::string& filename, const MeshLoadOptions& options) {
+    auto shared = std::make_shared<MeshHandle::Shared>();
+    shared->filename = filename;
+    shared->options = options;
+    {
+        std::lock_guard lock(_mutex);
+        _queue.push_back(shared);
+        while (_workers.size() < _worker_count) {
+            _workers.emplace_back(&MeshLoader::work, this);
+        }
+    }
+    _job_queued.notify_one();
+    return MeshHandle(std::move(shared));
+}
+
+MeshHandle MeshLoader::load_now(const std::string& filename, const MeshLoadOptions& options) {
+    auto shared = std::make_shared<MeshHandle::Shared>();
+    shared->filename = filename;
+    shared->options = options;
+    parse(*shared);
+    return MeshHandle(std::move(shared));
+}
+
+void MeshLoader::work() {
+    while (true) {
+        std::shared_ptr<MeshHandle::Shared> job;
+        {
+            std::unique_lock lock(_mutex);
+            _job_queued.wait(lock, [this] { return _stopping or not _queue.empty(); });
+            if (_stopping) {
+                return;
+            }
+            job = std::move(_queue.front());
+            _queue.pop_front();
+        }
+
+        parse(*job);
+    }
+}
+
+void MeshLoader::parse(MeshHandle::Shared& job) {
+    try {
+        // Each stage is fully written before its state is published, and never touched again
+        // A quantised load never builds the de-indexed triangles, so it peaks below a plain one
+        Mesh mesh(job.filename, [&](Mesh placeholder) {
+            job.placeholder = std::move(placeholder);
+            job.state.store(MeshHandle::State::Placeholder, std::memory_order_release);
+        }, job.options.quantise);
+        if (job.options.optimise and not mesh.indices.empty()) {
+            job.optimisation_report = MeshOptimiser::optimise(mesh);
+        }
+        if (job.options.quantise) {
+            job.quantised_mesh.emplace(mesh);
+        } else {
+            job.mesh = std::move(mesh);
+        }
+        finish(job, MeshHandle::State::Ready);
+    } catch (...) {
+        job.error = std::current_exception();
+        finish(job, MeshHandle::State::Failed);
+    }
+}
+
+void MeshLoader::finish(MeshHandle::Shared& job, const MeshHandle::State state) {
+    {
+        std::lock_guard lock(job.mutex);
+        job.state.store(state, std::memory_order_release);
+    }
+    job.finished.notify_all();
+}
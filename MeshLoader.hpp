@@ -0,0 +1,88 @@
+#pragma once
+
+#include "Mesh.hpp"
+#include "MeshOptimiser.hpp"
+#include "QuantisedMesh.hpp"
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <thread>
+#include <vector>
+
+
+struct MeshLoadOptions {
+    // Reorder for vertex locality and overdraw once parsed
+    bool optimise = false;
+    // Keep only the compact quantised form; faces are read as indices and never expanded into triangles
+    bool quantise = false;
+};
+
+
+// A mesh that may still be loading. Copies share the same load
+class MeshHandle {
+public:
+    enum class State : uint8_t {
+        Loading,     // Nothing to draw yet
+        Placeholder, // A bounding box is available
+        Ready,       // The full mesh is available
+        Failed
+    };
+
+    State state() const;
+    // The most complete mesh available, or nullptr while loading or once quantised; a failed load is rethrown here
+    const Mesh* mesh() const;
+    // The quantised mesh once a quantised load is ready, otherwise nullptr
+    const QuantisedMesh* quantised_mesh() const;
+    // What optimising achieved, once an optimised load is ready, otherwise nullptr
+    const MeshOptimisationReport* optimisation_report() const;
+    // Blocks until the load has finished
+    void wait() const;
+    const std::string& filename() const;
+private:
+    friend class MeshLoader;
+    struct Shared {
+        std::string filename;
+        MeshLoadOptions options;
+        std::atomic<State> state = State::Loading;
+        Mesh placeholder;
+        Mesh mesh;
+        std::optional<QuantisedMesh> quantised_mesh;
+        std::optional<MeshOptimisationReport> optimisation_report;
+        std::exception_ptr error;
+        std::mutex mutex;
+        std::condition_variable finished;
+    };
+    explicit MeshHandle(std::shared_ptr<Shared> shared) : _shared(std::move(shared)) {}
+    std::shared_ptr<Shared> _shared;
+};
+
+
+// Parses meshes on worker threads so that loading never stalls the render loop. The workers start with the first load
+class MeshLoader {
+public:
+    explicit MeshLoader(unsigned worker_count = std::max(std::thread::hardware_concurrency(), 2u) - 1);
+    ~MeshLoader();
+    MeshLoader(const MeshLoader&) = delete;
+    MeshLoader& operator=(const MeshLoader&) = delete;
+
+    MeshHandle load(const std::string& filename, const MeshLoadOptions& options = {});
+    // Parses on the calling thread, for callers that are already running one load per thread
+    static MeshHandle load_now(const std::string& filename, const MeshLoadOptions& options = {});
+private:
+    void work();
+    static void parse(MeshHandle::Shared&);
+    static void finish(MeshHandle::Shared&, MeshHandle::State);
+
+    unsigned _worker_count;
+    std::deque<std::shared_ptr<MeshHandle::Shared>> _queue;
+    bool _stopping = false;
+    std::mutex _mutex;
+    std::condition_variable _job_queued;
+    std::vector<std::thread> _workers;
+};
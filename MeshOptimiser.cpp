@@ -0,0 +1,233 @@
+#include "MeshOptimiser.hpp"
+
+#include <algorithm>
+#include <numeric>
+
+
+double MeshOptimiser::average_cache_miss_ratio(const std::span<const uint32_t> indices, const size_t vertex_count, const size_t cache_size) {
+    if (indices.size() < 3) {
+        return 0;
+    }
+    // A vertex is still cached if fewer than cache_size misses have happened since it was loaded
+    std::vector<size_t> loaded_at(vertex_count, 0);
+    size_t misses = 0;
+    for (const uint32_t index : indices) {
+        if (loaded_at[index] == 0 or misses - loaded_at[index] >= cache_size) {
+            ++misses;
+            loaded_at[index] = misses;
+        }
+    }
+    return static_cast<double>(misses) / static_cast<double>(indices.size() / 3);
+}
+
+std::vector<uint32_t> MeshOptimiser::optimise_vertex_cache(const std::span<const uint32_t> indices, const size_t vertex_count, const size_t cache_size, std::vector<size_t>& cluster_starts) {
+    const size_t triangle_count = indices.size() / 3;
+
+    // Triangles around each vertex, in compressed rows
+    std::vector<uint32_t> live(vertex_count, 0);
+    for (const uint32_t index : indices) {
+        ++live[index];
+    }
+    std::vector<size_t> offsets(vertex_count + 1, 0);
+    std::partial_sum(live.begin(), live.end(), offsets.begin() + 1);
+    std::vector<uint32_t> adjacency(indices.size());
+    {
+        std::vector<size_t> cursor(offsets.begin(), offsets.end() - 1);
+        for (size_t t = 0; t < triangle_count; ++t) {
+            for (size_t i = 0; i < 3; ++i) {
+                adjacency[cursor[indices[3 * t + i]]++] = static_cast<uint32_t>(t);
+            }
+        }
+    }
+
+    std::vector<size_t> cached_at(vertex_count, 0);
+    std::vector<bool> emitted(triangle_count, false);
+    std::vector<uint32_t> dead_ends;
+    std::vector<uint32_t> candidates;
+    std::vector<uint32_t> output;
+    output.reserve(indices.size());
+    cluster_starts.assign(1, 0);
+
+    size_t time = cache_size + 1;
+    size_t cursor = 0;
+
+    const auto skip_dead_end = [&]() -> int64_t {
+        while (not dead_ends.empty()) {
+            const uint32_t vertex = dead_ends.back();
+            dead_ends.pop_back();
+            if (live[vertex] > 0) {
+                return vertex;
+            }
+        }
+        for (; cursor < vertex_count; ++cursor) {
+            if (live[cursor] > 0) {
+                return static_cast<int64_t>(cursor);
+            }
+        }
+        return -1;
+    };
+
+    int64_t fan = vertex_count > 0 ? skip_dead_end() : -1;
+    while (fan >= 0) {
+        candidates.clear();
+        for (size_t a = offsets[fan]; a < offsets[fan + 1]; ++a) {
+            const uint32_t triangle = adjacency[a];
+            if (emitted[triangle]) {
+                continue;
+            }
+            for (size_t i = 0; i < 3; ++i) {
+                const uint32_t vertex = indices[3 * triangle + i];
+                output.push_back(vertex);
+                dead_ends.push_back(vertex);
+                candidates.push_back(vertex);
+                --live[vertex];
+                if (time - cached_at[vertex] > cache_size) {
+                    cached_at[vertex] = time++;
+                }
+            }
+            emitted[triangle] = true;
+        }
+
+        // Prefer the candidate that will still be cached once its remaining triangles are emitted
+        int64_t next = -1;
+        int64_t best = -1;
+        for (const uint32_t vertex : candidates) {
+            if (live[vertex] == 0) {
+                continue;
+            }
+            int64_t priority = 0;
+            if (time - cached_at[vertex] + 2 * live[vertex] <= cache_size) {
+                priority = static_cast<int64_t>(time - cached_at[vertex]);
+            }
+            if (priority > best) {
+                best = priority;
+                next = vertex;
+            }
+        }
+        if (next < 0) {
+            next = skip_dead_end();
+            if (next >= 0 and output.size() / 3 < triangle_count) {
+                cluster_starts.push_back(output.size() / 3);
+            }
+        }
+        fan = next;
+    }
+    return output;
+}
+
+void MeshOptimiser::optimise_overdraw(const std::span<uint32_t> indices, const std::span<const Vector3D> vertices, std::vector<size_t>& cluster_starts, const size_t cache_size, const double threshold) {
+    const size_t triangle_count = indices.size() / 3;
+    if (triangle_count == 0) {
+        return;
+    }
+
+    // Soft boundaries: inside each run, cut wherever the cache misses since the last cut fall below the threshold
+    std::vector<size_t> starts;
+    std::vector<size_t> loaded_at(vertices.size(), 0);
+    for (size_t c = 0; c < cluster_starts.size(); ++c) {
+        const size_t end = c + 1 < cluster_starts.size() ? cluster_starts[c + 1] : triangle_count;
+        size_t start = cluster_starts[c];
+        size_t misses = 0;
+        size_t clock = 0;
+        starts.push_back(start);
+        for (size_t t = start; t < end; ++t) {
+            for (size_t i = 0; i < 3; ++i) {
+                const uint32_t vertex = indices[3 * t + i];
+                if (loaded_at[vertex] == 0 or clock - loaded_at[vertex] >= cache_size) {
+                    ++misses;
+                    loaded_at[vertex] = ++clock;
+                }
+            }
+            if (t + 1 < end and static_cast<double>(misses) / static_cast<double>(t + 1 - start) < threshold) {
+                start = t + 1;
+                misses = 0;
+                clock += cache_size;
+                starts.push_back(start);
+            }
+        }
+        clock += cache_size;
+    }
+    cluster_starts = starts;
+
+    Vector3D mesh_centre;
+    Scalar mesh_area = 0;
+    struct Cluster {
+        size_t start;
+        size_t end;
+        double key;
+    };
+    std::vector<Cluster> clusters(cluster_starts.size());
+    std::vector<Vector3D> centres(clusters.size());
+    std::vector<Vector3D> normals(clusters.size());
+    for (size_t c = 0; c < clusters.size(); ++c) {
+        clusters[c].start = cluster_starts[c];
+        clusters[c].end = c + 1 < cluster_starts.size() ? cluster_starts[c + 1] : triangle_count;
+        Vector3D centre;
+        Vector3D normal;
+        Scalar area = 0;
+        for (size_t t = clusters[c].start; t < clusters[c].end; ++t) {
+            const Vector3D& v0 = vertices[indices[3 * t]];
+            const Vector3D& v1 = vertices[indices[3 * t + 1]];
+            const Vector3D& v2 = vertices[indices[3 * t + 2]];
+            const Vector3D weighted_normal = cross(v1 - v0, v2 - v0);
+            const Scalar triangle_area = weighted_normal.magnitude();
+            centre += (v0 + v1 + v2) * (triangle_area / 3);
+            normal += weighted_normal;
+            area += triangle_area;
+        }
+        mesh_centre += centre;
+        mesh_area += area;
+        centres[c] = area > 0 ? centre / area : vertices[indices[3 * clusters[c].start]];
+        normals[c] = normal.magnitude() > 0 ? normal.normalised() : normal;
+    }
+    if (mesh_area > 0) {
+        mesh_centre /= mesh_area;
+    }
+    for (size_t c = 0; c < clusters.size(); ++c) {
+        clusters[c].key = dot(centres[c] - mesh_centre, normals[c]);
+    }
+
+    std::ranges::stable_sort(clusters, [](const Cluster& a, const Cluster& b) { return a.key > b.key; });
+
+    std::vector<uint32_t> sorted;
+    sorted.reserve(indices.size());
+    cluster_starts.clear();
+    for (const auto& cluster : clusters) {
+        cluster_starts.push_back(sorted.size() / 3);
+        sorted.insert(sorted.end(), indices.begin() + 3 * cluster.start, indices.begin() + 3 * cluster.end);
+    }
+    std::ranges::copy(sorted, indices.begin());
+}
+
+void MeshOptimiser::optimise_vertex_fetch(std::vector<Vector3D>& vertices, const std::span<uint32_t> indices) {
+    constexpr uint32_t unassigned = ~0u;
+    std::vector<uint32_t> remap(vertices.size(), unassigned);
+    std::vector<Vector3D> reordered;
+    reordered.reserve(vertices.size());
+    for (uint32_t& index : indices) {
+        if (remap[index] == unassigned) {
+            remap[index] = static_cast<uint32_t>(reordered.size());
+            reordered.push_back(vertices[index]);
+        }
+        index = remap[index];
+    }
+    // Vertices no face refers to are dropped
+    vertices = std::move(reordered);
+}
+
+MeshOptimisationReport MeshOptimiser::optimise(Mesh& mesh, const size_t cache_size) {
+    MeshOptimisationReport report;
+    report.acmr_before = average_cache_miss_ratio(mesh.indices, mesh.vertices.size(), cache_size);
+
+    std::vector<size_t> cluster_starts;
+    mesh.indices = optimise_vertex_cache(mesh.indices, mesh.vertices.size(), cache_size, cluster_starts);
+    optimise_overdraw(mesh.indices, mesh.vertices, cluster_starts, cache_size);
+    optimise_vertex_fetch(mesh.vertices, mesh.indices);
+    if (not mesh.triangles.empty()) {
+        mesh.rebuild_triangles();
+    }
+
+    report.acmr_after = average_cache_miss_ratio(mesh.indices, mesh.vertices.size(), cache_size);
+    report.cluster_count = cluster_starts.size();
+    return report;
+}
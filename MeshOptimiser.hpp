@@ -0,0 +1,38 @@
+#pragma once
+
+#include "Mesh.hpp"
+
+#include <cstdint>
+#include <span>
+#include <vector>
+
+
+struct MeshOptimisationReport {
+    double acmr_before = 0;
+    double acmr_after = 0;
+    size_t cluster_count = 0;
+};
+
+
+// Load-time reordering of an indexed mesh, after Sander, Nehab and Barczak,
+// "Fast Triangle Reordering for Vertex Locality and Reduced Overdraw" (2007)
+namespace MeshOptimiser {
+    constexpr size_t default_cache_size = 16;
+
+    // Average transform cache misses per triangle for a FIFO cache of the given size
+    double average_cache_miss_ratio(std::span<const uint32_t> indices, size_t vertex_count, size_t cache_size = default_cache_size);
+
+    // Tipsify: greedily fans around cached vertices. Returns the new index order and
+    // fills cluster_starts with the first triangle of every run that had to restart
+    std::vector<uint32_t> optimise_vertex_cache(std::span<const uint32_t> indices, size_t vertex_count, size_t cache_size, std::vector<size_t>& cluster_starts);
+
+    // Splits clusters wherever their cache behaviour allows, then orders them so that
+    // outward-facing clusters far from the centre, the likely occluders, are drawn first
+    void optimise_overdraw(std::span<uint32_t> indices, std::span<const Vector3D> vertices, std::vector<size_t>& cluster_starts, size_t cache_size, double threshold = 0.75);
+
+    // Renumbers vertices in order of first use so that vertex fetches walk memory forwards
+    void optimise_vertex_fetch(std::vector<Vector3D>& vertices, std::span<uint32_t> indices);
+
+    // Runs every pass over mesh.indices and rebuilds mesh.triangles, if the mesh has them, in the new order
+    MeshOptimisationReport optimise(Mesh&, size_t cache_size = default_cache_size);
+}
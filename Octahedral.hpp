@@ -0,0 +1,42 @@
+#pragma once
+
+#include "Vector3D.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+
+
+// Unit vectors folded onto an octahedron and stored as two snorm16 components. A degenerate triangle's
+// zero-length, or not finite, normal is stored as (0, 0, 1)
+inline uint32_t encode_octahedral(const Vector3D& normal) {
+    const double length = std::abs(normal.x) + std::abs(normal.y) + std::abs(normal.z);
+    if (not (length > 0 and std::isfinite(length))) {
+        return 0;
+    }
+    double u = normal.x / length;
+    double v = normal.y / length;
+    if (normal.z < 0) {
+        const double folded_u = (1 - std::abs(v)) * (u >= 0 ? 1 : -1);
+        const double folded_v = (1 - std::abs(u)) * (v >= 0 ? 1 : -1);
+        u = folded_u;
+        v = folded_v;
+    }
+    const auto quantise = [](const double value) {
+        return static_cast<uint16_t>(static_cast<int16_t>(std::lround(std::clamp(value, -1.0, 1.0) * 32767)));
+    };
+    return static_cast<uint32_t>(quantise(u)) | static_cast<uint32_t>(quantise(v)) << 16;
+}
+
+inline Vector3D decode_octahedral(const uint32_t encoded) {
+    double u = static_cast<int16_t>(encoded & 0xFFFF) / 32767.0;
+    double v = static_cast<int16_t>(encoded >> 16) / 32767.0;
+    const double z = 1 - std::abs(u) - std::abs(v);
+    if (z < 0) {
+        const double unfolded_u = (1 - std::abs(v)) * (u >= 0 ? 1 : -1);
+        const double unfolded_v = (1 - std::abs(u)) * (v >= 0 ? 1 : -1);
+        u = unfolded_u;
+        v = unfolded_v;
+    }
+    return Vector3D(static_cast<Scalar>(u), static_cast<Scalar>(v), static_cast<Scalar>(z)).normalised();
+}
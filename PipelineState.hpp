@@ -0,0 +1,37 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+
+// Fixed-function raster state. Every combination is compiled into its own kernel, so the
+// per-pixel loops test no features at run time; a new feature is a new member here plus
+// an `if constexpr` in the kernels
+struct PipelineState {
+    enum class Fill : uint8_t {
+        Solid,
+        Edges,
+        SolidWithEdges
+    };
+    Fill fill = Fill::Solid;
+    uint8_t samples = 1;
+
+    static constexpr std::array<uint8_t, 4> sample_counts = { 1, 2, 4, 8 };
+    static constexpr size_t count = 3 * sample_counts.size();
+
+    // Dense index into a dispatch table of count entries
+    constexpr size_t index() const {
+        size_t sample_index = 0;
+        while (sample_index + 1 < sample_counts.size() and sample_counts[sample_index] != samples) {
+            ++sample_index;
+        }
+        return static_cast<size_t>(fill) * sample_counts.size() + sample_index;
+    }
+    static constexpr PipelineState from_index(const size_t index) {
+        return { static_cast<Fill>(index / sample_counts.size()), sample_counts[index % sample_counts.size()] };
+    }
+
+    constexpr bool solid() const { return fill != Fill::Edges; }
+    constexpr bool edges() const { return fill != Fill::Solid; }
+};
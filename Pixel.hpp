@@ -0,0 +1,11 @@
+#pragma once
+
+#include <cstdint>
+
+
+struct Pixel {
+    uint8_t red;
+    uint8_t green;
+    uint8_t blue;
+    uint8_t alpha = 255;
+};
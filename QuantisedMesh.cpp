@@ -0,0 +1,59 @@
+#include "QuantisedMesh.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+
+
+QuantisedMesh::QuantisedMesh(const Mesh& mesh) {
+    if (mesh.indices.empty() or mesh.vertices.empty()) {
+        throw std::runtime_error("Only indexed meshes can be quantised");
+    }
+
+    Vector3D minimum = mesh.vertices.front();
+    Vector3D maximum = mesh.vertices.front();
+    for (const auto& vertex : mesh.vertices) {
+        minimum = { std::min(minimum.x, vertex.x), std::min(minimum.y, vertex.y), std::min(minimum.z, vertex.z) };
+        maximum = { std::max(maximum.x, vertex.x), std::max(maximum.y, vertex.y), std::max(maximum.z, vertex.z) };
+    }
+
+    constexpr Scalar steps = std::numeric_limits<uint16_t>::max();
+    const Vector3D extent = maximum - minimum;
+    const std::array<Scalar, 3> scale = {
+        extent.x > 0 ? extent.x / steps : 1,
+        extent.y > 0 ? extent.y / steps : 1,
+        extent.z > 0 ? extent.z / steps : 1
+    };
+    _dequantisation = make_translation_matrix(minimum) * make_scaling_matrix(scale[0], scale[1], scale[2]);
+
+    _positions.reserve(mesh.vertices.size());
+    for (const auto& vertex : mesh.vertices) {
+        const auto quantise = [&](const Scalar value, const Scalar origin, const Scalar step) {
+            return static_cast<uint16_t>(std::clamp(std::lround((value - origin) / step), 0l, static_cast<long>(steps)));
+        };
+        _positions.push_back({ quantise(vertex.x, minimum.x, scale[0]), quantise(vertex.y, minimum.y, scale[1]), quantise(vertex.z, minimum.z, scale[2]) });
+    }
+
+    // Face normals come from the original positions, so quantisation does not bend the shading
+    const size_t triangle_count = mesh.indices.size() / 3;
+    _normals.reserve(triangle_count);
+    for (size_t t = 0; t < triangle_count; ++t) {
+        const Vector3D& a = mesh.vertices[mesh.indices[3 * t]];
+        const Vector3D& b = mesh.vertices[mesh.indices[3 * t + 1]];
+        const Vector3D& c = mesh.vertices[mesh.indices[3 * t + 2]];
+        const Vector3D normal = cross(b - a, c - a);
+        _normals.push_back(encode_octahedral(normal.magnitude() > 0 ? normal.normalised() : Vector3D(0, 0, 1)));
+    }
+
+    if (mesh.vertices.size() <= std::numeric_limits<uint16_t>::max() + size_t{ 1 }) {
+        _indices = std::vector<uint16_t>(mesh.indices.begin(), mesh.indices.begin() + 3 * triangle_count);
+    } else {
+        _indices = std::vector<uint32_t>(mesh.indices.begin(), mesh.indices.begin() + 3 * triangle_count);
+    }
+}
+
+size_t QuantisedMesh::memory_usage() const {
+    const size_t index_bytes = std::visit([](const auto& indices) { return indices.size() * sizeof(indices[0]); }, _indices);
+    return _positions.size() * sizeof(_positions[0]) + _normals.size() * sizeof(_normals[0]) + index_bytes;
+}
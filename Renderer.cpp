@@ -1,9 +1,80 @@
 #include "Renderer.hpp"
 
+#include "SimdKernels.hpp"
+
 #include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <utility>
+
+
+namespace {
+    // Standard multisample patterns, in sixteenths of a pixel from the pixel centre.
+    constexpr std::array<Coordinate, 1> sample_pattern_1 = { { { 0, 0 } } };
+    constexpr std::array<Coordinate, 2> sample_pattern_2 = { { { 4, 4 }, { -4, -4 } } };
+    constexpr std::array<Coordinate, 4> sample_pattern_4 = { { { -2, -6 }, { 6, -2 }, { -6, 2 }, { 2, 6 } } };
+    constexpr std::array<Coordinate, 8> sample_pattern_8 = { {
+        { 1, -3 }, { -1, 3 }, { 5, 1 }, { -3, -5 }, { -5, 5 }, { -7, -1 }, { 3, 7 }, { 7, -7 }
+    } };
+
+    template <int samples>
+    constexpr const auto& sample_pattern() {
+        if constexpr (samples == 1) {
+            return sample_pattern_1;
+        } else if constexpr (samples == 2) {
+            return sample_pattern_2;
+        } else if constexpr (samples == 4) {
+            return sample_pattern_4;
+        } else {
+            return sample_pattern_8;
+        }
+    }
+
+    // 3x5 glyphs for the statistics overlay, one bit per pixel, top row in the most significant bits
+    constexpr int glyph_width = 3;
+    constexpr int glyph_height = 5;
+    constexpr int glyph_scale = 2;
+    constexpr std::pair<char, uint16_t> glyphs[] = {
+        { '0', 0b111101101101111 }, { '1', 0b010110010010111 }, { '2', 0b111001111100111 }, { '3', 0b111001111001111 }, { '4', 0b101101111001001 },
+        { '5', 0b111100111001111 }, { '6', 0b111100111101111 }, { '7', 0b111001001001001 }, { '8', 0b111101111101111 }, { '9', 0b111101111001111 },
+        { 'A', 0b010101111101101 }, { 'B', 0b110101110101110 }, { 'C', 0b011100100100011 }, { 'D', 0b110101101101110 }, { 'E', 0b111100110100111 },
+        { 'F', 0b111100110100100 }, { 'G', 0b011100101101011 }, { 'H', 0b101101111101101 }, { 'I', 0b111010010010111 }, { 'J', 0b001001001101010 },
+        { 'K', 0b101101110101101 }, { 'L', 0b100100100100111 }, { 'M', 0b101111111101101 }, { 'N', 0b110101101101101 }, { 'O', 0b010101101101010 },
+        { 'P', 0b110101110100100 }, { 'Q', 0b010101101110011 }, { 'R', 0b110101110101101 }, { 'S', 0b011100010001110 }, { 'T', 0b111010010010010 },
+        { 'U', 0b101101101101111 }, { 'V', 0b101101101101010 }, { 'W', 0b101101111111101 }, { 'X', 0b101101010101101 }, { 'Y', 0b101101010010010 },
+        { 'Z', 0b111001010100111 }, { '.', 0b000000000000010 }, { ':', 0b000010000010000 }, { '%', 0b101001010100101 }, { '/', 0b001001010100100 },
+        { '-', 0b000000111000000 }
+    };
+
+    uint16_t glyph(const char character) {
+        const char upper = character >= 'a' and character <= 'z' ? static_cast<char>(character - 'a' + 'A') : character;
+        for (const auto& [key, bits] : glyphs) {
+            if (key == upper) {
+                return bits;
+            }
+        }
+        return 0;
+    }
+
+    // Internal resolution moves in steps of an eighth of the window size
+    constexpr double resolution_band = 0.125;
+
+    // Frames per second of simulated time for headless runs that are not recording
+    constexpr int headless_frame_rate = 30;
+}
+
+
+Renderer::Renderer(const int width, const int height, const std::string& title, const Display display) : _width(width), _height(height), _window_width(width), _window_height(height), _display(display), _pixels(static_cast<size_t>(width) * height), _frame(_pixels) {
+    _mouse_position = { width / 2, height / 2 };
+    _mouse_buttons.fill(ButtonState::Released);
+    _keys.fill(ButtonState::Released);
 
+    if (_display == Display::Headless) {
+        return;
+    }
+
+    _screen_pixels.resize(static_cast<size_t>(width) * height);
 
-Renderer::Renderer(const int width, const int height, const std::string& title) : _width(width), _height(height), _pixels(width, std::vector<Pixel>(height)) {
     if (SDL_Init(SDL_INIT_VIDEO) < 0) {
         throw SDLException("SDL could not initialize");
     }
@@ -18,6 +89,7 @@ Renderer::Renderer(const int width, const int height, const std::string& title)
         throw SDLException("Renderer could not be created");
     }
 
+    SDL_SetHint(SDL_HINT_RENDER_SCALE_QUALITY, "linear");
     _screen = SDL_CreateTexture(_renderer, SDL_PIXELFORMAT_RGBA8888, SDL_TEXTUREACCESS_STREAMING, _width, _height);
     if (_screen == nullptr) {
         throw SDLException("Screen texture could not be created");
@@ -25,34 +97,145 @@ Renderer::Renderer(const int width, const int height, const std::string& title)
 }
 
 Renderer::~Renderer() {
+    _frame_writer.reset();
+    if (_display == Display::Headless) {
+        return;
+    }
     SDL_DestroyWindow(_window);
     _window = nullptr;
     SDL_Quit();
 }
 
 void Renderer::run() {
-    Timer::start();
+    Statistics::CollectorScope collector(_statistics_collector);
+    auto frame_start = std::chrono::steady_clock::now();
     sleep(1);
 
     initialise();
 
     while (_running) {
-        Timer::stop();
+        const auto now = std::chrono::steady_clock::now();
+        double frame_time = std::chrono::duration<double>(now - frame_start).count();
+        frame_start = now;
+        _statistics = _statistics_collector.collect();
+        _statistics.frame_time = frame_time;
+        _statistics.render_time = _render_time;
+        _statistics.overdraw = static_cast<double>(_statistics.pixels_written) / (static_cast<double>(_width) * _height);
+        _frame_times[_frame_time_index] = frame_time;
+        _frame_time_index = (_frame_time_index + 1) % _frame_times.size();
+
+        govern_resolution();
+
+        if (_frame_writer != nullptr or _display == Display::Headless) {
+            // Recordings and headless runs advance by a fixed step so their motion does not depend on render speed
+            frame_time = 1.0 / (_frame_writer != nullptr ? _frame_writer->frame_rate() : headless_frame_rate);
+        }
 
-        const double frame_time = Timer::elapsed();
-        const double frame_rate = 1 / frame_time;
-        std::cout << "Frame rate: " << frame_rate << '\r';
+        {
+            Statistics::ScopedTimer timer(Stage::Events);
+            JobSystem::TraceScope scope(jobs(), "Events");
+            handle_events();
+        }
 
-        Timer::restart();
+        // While exporting, the frame is drawn straight into a free slot of the ring, if there is one
+        if (_frame_ring != nullptr and _frame_slot.empty()) {
+            _frame_slot = _frame_ring->acquire();
+        }
+        const std::span<Pixel> previous_frame = _frame;
+        _frame = _frame_slot.empty() ? std::span<Pixel>(_pixels) : _frame_slot;
+
+        const auto render_start = std::chrono::steady_clock::now();
+        {
+            JobSystem::TraceScope scope(jobs(), "Update");
+            _frame_kept = false;
+            update(frame_time);
+        }
+        _idle = _frame_kept and not _statistics_overlay;
+        if (_idle) {
+            // Nothing was drawn, so the last frame stays where it is and any slot waits for the next
+            _frame = previous_frame;
+        } else if (_frame_kept and _sample_count == 1 and _frame.data() != previous_frame.data()) {
+            // The overlay goes over the kept frame, which must first be brought into the new target
+            std::ranges::copy(previous_frame, _frame.begin());
+        }
 
-        handle_events();
+        if (_statistics_overlay) {
+            draw_statistics_overlay();
+        }
 
-        update(frame_time);
+        if (not _idle) {
+            Statistics::ScopedTimer timer(Stage::Resolve);
+            JobSystem::TraceScope scope(jobs(), "Resolve");
+            resolve();
+        }
+        _render_time = std::chrono::duration<double>(std::chrono::steady_clock::now() - render_start).count();
+        {
+            Statistics::ScopedTimer timer(Stage::Present);
+            JobSystem::TraceScope scope(jobs(), "Present");
+            if (_frame_writer != nullptr) {
+                capture(_frame_writer->acquire());
+                _frame_writer->submit();
+            }
+            // An idle frame is the one the consumer already has
+            if (_frame_ring != nullptr and not _idle) {
+                if (_frame_slot.empty()) {
+                    _frame_ring->drop();
+                } else {
+                    _frame_ring->submit(render_start);
+                    _frame_slot = {};
+                }
+            }
+            if (_display == Display::Window) {
+                render();
+            }
+        }
 
-        render();
+        if (_frame_limit > 0 and ++_frame_count >= _frame_limit) {
+            _running = false;
+        }
     }
 
     close();
+
+    if (not _trace_path.empty()) {
+        jobs().write_trace(_trace_path);
+    }
+}
+
+void Renderer::record(const std::string& path, const FrameWriter::Format format, const int frame_rate) {
+    _frame_writer = std::make_unique<FrameWriter>(path, format, _width, _height, frame_rate);
+}
+
+void Renderer::export_frames(const std::string& name, const size_t slot_count) {
+    _frame_ring = std::make_unique<SharedFrameRing>(name, _width, _height, slot_count);
+}
+
+void Renderer::configure_jobs(const JobSystem::Options& options) {
+    _job_options = options;
+    _jobs.reset();
+}
+
+void Renderer::trace(const std::string& path) {
+    _trace_path = path;
+    if (_jobs != nullptr) {
+        _jobs->set_tracing(true);
+    }
+}
+
+// Started on first use, so that the thread running the frames owns it
+JobSystem& Renderer::jobs() {
+    if (_jobs == nullptr) {
+        auto options = _job_options;
+        options.thread_start = [this, start = _job_options.thread_start](const unsigned thread) {
+            Statistics::set_current(&_statistics_collector);
+            if (start) {
+                start(thread);
+            }
+        };
+        _jobs = std::make_unique<JobSystem>(options);
+        _jobs->set_tracing(not _trace_path.empty());
+    }
+    return *_jobs;
 }
 
 Coordinate Renderer::mouse_position() const {
@@ -79,8 +262,14 @@ Renderer::ButtonState Renderer::key(const char key) const {
 }
 
 void Renderer::handle_events() {
+    if (_display == Display::Headless) {
+        return;
+    }
     SDL_Event event;
-    while (SDL_PollEvent(&event) != 0) {
+    // Recordings advance at a fixed step, so only an interactive idle frame sleeps until something happens
+    const bool wait = _idle and _frame_writer == nullptr;
+    int pending = wait ? SDL_WaitEventTimeout(&event, idle_wait_milliseconds) : SDL_PollEvent(&event);
+    for (; pending != 0; pending = SDL_PollEvent(&event)) {
         switch (event.type) {
             case SDL_QUIT: {
                 _running = false;
@@ -111,8 +300,16 @@ void Renderer::handle_events() {
                 break;
             }
             case SDL_MOUSEMOTION: {
-                _mouse_position.x = event.motion.x;
-                _mouse_position.y = event.motion.y;
+                _mouse_position.x = event.motion.x * _width / _window_width;
+                _mouse_position.y = event.motion.y * _height / _window_height;
+                break;
+            }
+            case SDL_WINDOWEVENT: {
+                if (event.window.event == SDL_WINDOWEVENT_SIZE_CHANGED) {
+                    _window_width = std::max(event.window.data1, 1);
+                    _window_height = std::max(event.window.data2, 1);
+                    apply_resolution();
+                }
                 break;
             }
             default: {
@@ -132,19 +329,150 @@ void Renderer::update(const double frame_time) {
 
 void Renderer::close() {}
 
+void Renderer::resize() {}
+
+void Renderer::set_dynamic_resolution(const double target_frame_time, const double minimum_scale, const double maximum_scale) {
+    if (minimum_scale <= 0 or minimum_scale > maximum_scale) {
+        throw std::runtime_error("Invalid resolution scale bounds");
+    }
+    _target_frame_time = target_frame_time;
+    _minimum_scale = minimum_scale;
+    _maximum_scale = maximum_scale;
+    _resolution_scale = std::clamp(_resolution_scale, minimum_scale, maximum_scale);
+    apply_resolution();
+}
+
+void Renderer::govern_resolution() {
+    if (_target_frame_time <= 0 or _frame_writer != nullptr or _frame_ring != nullptr) {
+        return;
+    }
+
+    // Presenting waits on vertical sync, so only the time spent producing the frame is measured
+    const double cost = _statistics.render_time;
+    if (cost <= 0) {
+        return;
+    }
+
+    if (cost > _target_frame_time) {
+        ++_frames_over_budget;
+        _frames_under_budget = 0;
+    } else if (cost < _target_frame_time * 0.7) {
+        ++_frames_under_budget;
+        _frames_over_budget = 0;
+    } else {
+        _frames_over_budget = 0;
+        _frames_under_budget = 0;
+    }
+
+    double scale;
+    if (_frames_over_budget >= 3) {
+        // Raster cost follows the pixel count, so drop straight to the band expected to fit
+        scale = std::floor(_resolution_scale * std::sqrt(_target_frame_time / cost) / resolution_band) * resolution_band;
+    } else if (_frames_under_budget >= 30) {
+        scale = _resolution_scale + resolution_band;
+    } else {
+        return;
+    }
+    _frames_over_budget = 0;
+    _frames_under_budget = 0;
+
+    scale = std::clamp(scale, _minimum_scale, _maximum_scale);
+    if (scale != _resolution_scale) {
+        _resolution_scale = scale;
+        apply_resolution();
+    }
+}
+
+void Renderer::apply_resolution() {
+    // Recordings and exports keep the size they were opened with; the window just stretches the frame
+    if (_frame_writer != nullptr or _frame_ring != nullptr) {
+        return;
+    }
+    const int width = std::max(static_cast<int>(std::lround(_window_width * _resolution_scale)), 1);
+    const int height = std::max(static_cast<int>(std::lround(_window_height * _resolution_scale)), 1);
+    if (width == _width and height == _height) {
+        return;
+    }
+
+    _width = width;
+    _height = height;
+    _pixels.assign(static_cast<size_t>(width) * height, Pixel{});
+    _frame = _pixels;
+    set_sample_count(_sample_count);
+
+    if (_display == Display::Window) {
+        _screen_pixels.assign(static_cast<size_t>(width) * height, 0);
+        SDL_DestroyTexture(_screen);
+        _screen = SDL_CreateTexture(_renderer, SDL_PIXELFORMAT_RGBA8888, SDL_TEXTUREACCESS_STREAMING, _width, _height);
+        if (_screen == nullptr) {
+            throw SDLException("Screen texture could not be created");
+        }
+    }
+
+    resize();
+}
+
+void Renderer::set_sample_count(const int samples) {
+    if (std::ranges::find(PipelineState::sample_counts, samples) == PipelineState::sample_counts.end()) {
+        throw std::runtime_error("Invalid sample count " + std::to_string(samples));
+    }
+    _sample_count = samples;
+    if (_sample_count > 1) {
+        _samples.assign(static_cast<size_t>(_width) * _height * _sample_count, Pixel{ 0, 0, 0 });
+    } else {
+        _samples.clear();
+        _samples.shrink_to_fit();
+    }
+}
+
 void Renderer::clear(const Pixel& pixel) {
-    for (int x = 0; x < _width; ++x) {
-        for (int y = 0; y < _height; ++y) {
-            _pixels[x][y] = pixel;
+    const auto& kernels = SimdKernels::active();
+    if (_sample_count > 1) {
+        kernels.fill(_samples.data(), _samples.size(), pixel);
+        return;
+    }
+    kernels.fill(_frame.data(), _frame.size(), pixel);
+}
+
+void Renderer::clear(const Pixel& pixel, const Scissor& scissor) {
+    const Scissor area = clip(scissor);
+    if (area.minimum.x >= area.maximum.x or area.minimum.y >= area.maximum.y) {
+        return;
+    }
+    const auto& kernels = SimdKernels::active();
+    if (_sample_count > 1) {
+        const size_t row_samples = static_cast<size_t>(area.maximum.x - area.minimum.x) * _sample_count;
+        for (int y = area.minimum.y; y < area.maximum.y; ++y) {
+            kernels.fill(&_samples[(static_cast<size_t>(y) * _width + area.minimum.x) * _sample_count], row_samples, pixel);
         }
+        return;
     }
+    for (int y = area.minimum.y; y < area.maximum.y; ++y) {
+        kernels.fill(&frame_pixel(area.minimum.x, y), area.maximum.x - area.minimum.x, pixel);
+    }
+}
+
+Renderer::Scissor Renderer::clip(const Scissor& scissor) const {
+    return {
+        { std::max(scissor.minimum.x, 0), std::max(scissor.minimum.y, 0) },
+        { std::min(scissor.maximum.x, _width), std::min(scissor.maximum.y, _height) }
+    };
 }
 
 void Renderer::draw_pixel(const Coordinate& coordinate, const Pixel& pixel) {
+    Statistics::local().pixels_written += plot(coordinate, pixel);
+}
+
+bool Renderer::plot(const Coordinate& coordinate, const Pixel& pixel) {
     if (coordinate.x >= _width or coordinate.x < 0 or coordinate.y >= _height or coordinate.y < 0) {
-        return;
+        return false;
     }
-    _pixels[coordinate.x][coordinate.y] = pixel;
+    if (_sample_count > 1) {
+        write_samples(coordinate, (1u << _sample_count) - 1, pixel);
+        return true;
+    }
+    frame_pixel(coordinate.x, coordinate.y) = pixel;
+    return true;
 }
 
 void Renderer::draw_line(const Coordinate& start, const Coordinate& end, const Pixel& pixel) {
@@ -158,10 +486,11 @@ void Renderer::draw_line(const Coordinate& start, const Coordinate& end, const P
         start.y < end.y ? 1 : -1
     };
 
+    uint64_t written = 0;
     if (delta.x > delta.y) {
         int error = delta.x / 2;
         while (current.x != end.x) {
-            draw_pixel(current, pixel);
+            written += plot(current, pixel);
             error -= delta.y;
             if (error < 0) {
                 current.y += step.y;
@@ -172,7 +501,7 @@ void Renderer::draw_line(const Coordinate& start, const Coordinate& end, const P
     } else {
         int error = delta.y / 2;
         while (current.y != end.y) {
-            draw_pixel(current, pixel);
+            written += plot(current, pixel);
             error -= delta.x;
             if (error < 0) {
                 current.x += step.x;
@@ -181,15 +510,60 @@ void Renderer::draw_line(const Coordinate& start, const Coordinate& end, const P
             current.y += step.y;
         }
     }
+    Statistics::local().pixels_written += written;
 }
 
 void Renderer::draw_triangle(std::array<Coordinate, 3> coordinates, const Pixel& pixel) {
-    draw_line(coordinates[0], coordinates[1], pixel);
-    draw_line(coordinates[1], coordinates[2], pixel);
-    draw_line(coordinates[2], coordinates[0], pixel);
+    const RasterTriangle triangle = { coordinates, pixel };
+    draw_triangles({ &triangle, 1 }, PipelineState::Fill::Edges, pixel);
 }
 
 void Renderer::draw_filled_triangle(std::array<Coordinate, 3> coordinates, const Pixel& pixel) {
+    const RasterTriangle triangle = { coordinates, pixel };
+    draw_triangles({ &triangle, 1 }, PipelineState::Fill::Solid);
+}
+
+void Renderer::draw_triangles(const std::span<const RasterTriangle> triangles, const PipelineState::Fill fill, const Pixel& edge) {
+    draw_triangles(triangles, fill, edge, screen());
+}
+
+void Renderer::draw_triangles(const std::span<const RasterTriangle> triangles, const PipelineState::Fill fill, const Pixel& edge, const Scissor& scissor) {
+    using Kernel = void (Renderer::*)(std::span<const RasterTriangle>, const Pixel&, const Scissor&);
+    static constexpr auto kernels = []<size_t... indices>(std::index_sequence<indices...>) {
+        return std::array<Kernel, PipelineState::count>{ &Renderer::rasterise<PipelineState::from_index(indices)>... };
+    }(std::make_index_sequence<PipelineState::count>());
+
+    const PipelineState state = { fill, static_cast<uint8_t>(_sample_count) };
+    (this->*kernels[state.index()])(triangles, edge, clip(scissor));
+}
+
+template <PipelineState state>
+void Renderer::rasterise(const std::span<const RasterTriangle> triangles, const Pixel& edge, const Scissor& scissor) {
+    uint64_t written = 0;
+    if constexpr (state.solid()) {
+        for (const auto& triangle : triangles) {
+            if constexpr (state.samples > 1) {
+                const auto& [a, b, c] = triangle.coordinates;
+                const auto corners = triangle.subpixel_coordinates.value_or(std::array{ a * subpixel, b * subpixel, c * subpixel });
+                written += fill_multisampled_triangle<state>(corners, triangle.fill, scissor);
+            } else {
+                written += fill_triangle<state>(triangle.coordinates, triangle.fill, scissor);
+            }
+        }
+    }
+    if constexpr (state.edges()) {
+        for (const auto& triangle : triangles) {
+            const auto& [a, b, c] = triangle.coordinates;
+            written += draw_edge<state>(a, b, edge, scissor);
+            written += draw_edge<state>(b, c, edge, scissor);
+            written += draw_edge<state>(c, a, edge, scissor);
+        }
+    }
+    Statistics::local().pixels_written += written;
+}
+
+template <PipelineState state>
+uint64_t Renderer::fill_triangle(std::array<Coordinate, 3> coordinates, const Pixel& pixel, const Scissor& scissor) {
     std::ranges::sort(coordinates.begin(), coordinates.end(), [](const Coordinate& a, const Coordinate& b) { return a.y < b.y; });
     const auto [top, middle, bottom] = coordinates;
 
@@ -197,10 +571,25 @@ void Renderer::draw_filled_triangle(std::array<Coordinate, 3> coordinates, const
     const double slope_top_to_bottom = static_cast<double>(bottom.x - top.x) / (bottom.y - top.y);
     const double slope_middle_to_bottom = static_cast<double>(bottom.x - middle.x) / (bottom.y - middle.y);
 
+    // Spans run from the first edge towards, but not including, the second, clipped to the scissor
+    const auto& kernels = SimdKernels::active();
+    uint64_t written = 0;
+    const auto span = [&](const int y, const int from, const int to) {
+        if (y < scissor.minimum.y or y >= scissor.maximum.y or from == to) {
+            return;
+        }
+        const int first = std::max(from < to ? from : to + 1, scissor.minimum.x);
+        const int last = std::min(from < to ? to - 1 : from, scissor.maximum.x - 1);
+        if (first <= last) {
+            kernels.fill(&frame_pixel(first, y), last - first + 1, pixel);
+        }
+        written += std::max(last - first + 1, 0);
+    };
+
     double x1 = top.x;
     double x2 = top.x + 0.5;
     for (int y = top.y; y <= middle.y; ++y) {
-        draw_line({ static_cast<int>(x1), y }, { static_cast<int>(x2), y }, pixel);
+        span(y, static_cast<int>(x1), static_cast<int>(x2));
         x1 += slope_top_to_middle;
         x2 += slope_top_to_bottom;
     }
@@ -208,10 +597,159 @@ void Renderer::draw_filled_triangle(std::array<Coordinate, 3> coordinates, const
     x1 = middle.x;
     x2 = middle.x + 0.5;
     for (int y = middle.y; y <= bottom.y; ++y) {
-        draw_line({ static_cast<int>(x1), y }, { static_cast<int>(x2), y }, pixel);
+        span(y, static_cast<int>(x1), static_cast<int>(x2));
         x1 += slope_middle_to_bottom;
         x2 += slope_top_to_bottom;
     }
+    return written;
+}
+
+template <PipelineState state>
+uint64_t Renderer::fill_multisampled_triangle(std::array<Coordinate, 3> coordinates, const Pixel& pixel, const Scissor& scissor) {
+    // Corners and sample positions are both in sixteenths of a pixel, so every edge function is exact
+    constexpr auto pattern = sample_pattern<state.samples>();
+
+    auto& [a, b, c] = coordinates;
+    const int64_t area = static_cast<int64_t>(b.x - a.x) * (c.y - a.y) - static_cast<int64_t>(b.y - a.y) * (c.x - a.x);
+    if (area == 0) {
+        return 0;
+    }
+    if (area < 0) {
+        std::swap(b, c);
+    }
+
+    // The pixels holding the corners; the shift rounds down for corners left of or above the frame too
+    const Coordinate minimum = {
+        std::max(std::min({ a.x, b.x, c.x }) >> subpixel_bits, scissor.minimum.x),
+        std::max(std::min({ a.y, b.y, c.y }) >> subpixel_bits, scissor.minimum.y)
+    };
+    const Coordinate maximum = {
+        std::min(std::max({ a.x, b.x, c.x }) >> subpixel_bits, scissor.maximum.x - 1),
+        std::min(std::max({ a.y, b.y, c.y }) >> subpixel_bits, scissor.maximum.y - 1)
+    };
+    if (minimum.x > maximum.x or minimum.y > maximum.y) {
+        return 0;
+    }
+
+    struct Edge {
+        int64_t step_x;
+        int64_t step_y;
+        int64_t row;
+        std::array<int64_t, state.samples> sample_offsets;
+    };
+    std::array<Edge, 3> edges;
+    for (size_t i = 0; i < 3; ++i) {
+        const Coordinate& from = coordinates[i];
+        const Coordinate& to = coordinates[(i + 1) % 3];
+        const int64_t dx = from.y - to.y;
+        const int64_t dy = to.x - from.x;
+        // Top-left fill rule: samples exactly on a right or bottom edge belong to the neighbouring triangle
+        const int64_t bias = dx > 0 or (dx == 0 and dy > 0) ? 0 : -1;
+        const int64_t centre_x = static_cast<int64_t>(minimum.x) * subpixel + subpixel / 2 - from.x;
+        const int64_t centre_y = static_cast<int64_t>(minimum.y) * subpixel + subpixel / 2 - from.y;
+        edges[i].step_x = dx * subpixel;
+        edges[i].step_y = dy * subpixel;
+        edges[i].row = dx * centre_x + dy * centre_y + bias;
+        for (size_t s = 0; s < pattern.size(); ++s) {
+            edges[i].sample_offsets[s] = dx * pattern[s].x + dy * pattern[s].y;
+        }
+    }
+
+    uint64_t written = 0;
+    for (int y = minimum.y; y <= maximum.y; ++y) {
+        std::array<int64_t, 3> centre = { edges[0].row, edges[1].row, edges[2].row };
+        for (int x = minimum.x; x <= maximum.x; ++x) {
+            uint32_t coverage = 0;
+            for (size_t s = 0; s < pattern.size(); ++s) {
+                if (centre[0] + edges[0].sample_offsets[s] >= 0 and
+                    centre[1] + edges[1].sample_offsets[s] >= 0 and
+                    centre[2] + edges[2].sample_offsets[s] >= 0) {
+                    coverage |= 1u << s;
+                }
+            }
+            if (coverage != 0) {
+                write_samples<state>({ x, y }, coverage, pixel);
+                ++written;
+            }
+            for (size_t i = 0; i < 3; ++i) {
+                centre[i] += edges[i].step_x;
+            }
+        }
+        for (auto& edge : edges) {
+            edge.row += edge.step_y;
+        }
+    }
+    return written;
+}
+
+template <PipelineState state>
+uint64_t Renderer::draw_edge(const Coordinate& start, const Coordinate& end, const Pixel& pixel, const Scissor& scissor) {
+    Coordinate current = start;
+    const Coordinate delta = {
+        std::abs(end.x - start.x),
+        std::abs(end.y - start.y)
+    };
+    const Coordinate step = {
+        start.x < end.x ? 1 : -1,
+        start.y < end.y ? 1 : -1
+    };
+
+    uint64_t written = 0;
+    const auto write = [&] {
+        if (current.x >= scissor.maximum.x or current.x < scissor.minimum.x or current.y >= scissor.maximum.y or current.y < scissor.minimum.y) {
+            return;
+        }
+        if constexpr (state.samples > 1) {
+            write_samples<state>(current, (1u << state.samples) - 1, pixel);
+        } else {
+            frame_pixel(current.x, current.y) = pixel;
+        }
+        ++written;
+    };
+
+    if (delta.x > delta.y) {
+        int error = delta.x / 2;
+        while (current.x != end.x) {
+            write();
+            error -= delta.y;
+            if (error < 0) {
+                current.y += step.y;
+                error += delta.x;
+            }
+            current.x += step.x;
+        }
+    } else {
+        int error = delta.y / 2;
+        while (current.y != end.y) {
+            write();
+            error -= delta.x;
+            if (error < 0) {
+                current.x += step.x;
+                error += delta.y;
+            }
+            current.y += step.y;
+        }
+    }
+    return written;
+}
+
+template <PipelineState state>
+void Renderer::write_samples(const Coordinate& coordinate, const uint32_t coverage, const Pixel& pixel) {
+    const auto samples = _samples.begin() + (static_cast<size_t>(coordinate.y) * _width + coordinate.x) * state.samples;
+    for (size_t s = 0; s < state.samples; ++s) {
+        if (coverage & 1u << s) {
+            samples[s] = pixel;
+        }
+    }
+}
+
+void Renderer::write_samples(const Coordinate& coordinate, const uint32_t coverage, const Pixel& pixel) {
+    const auto samples = _samples.begin() + (static_cast<size_t>(coordinate.y) * _width + coordinate.x) * _sample_count;
+    for (int s = 0; s < _sample_count; ++s) {
+        if (coverage & 1u << s) {
+            samples[s] = pixel;
+        }
+    }
 }
 
 void Renderer::draw_rectangle(const Coordinate& top_left, const Coordinate& bottom_right, const Pixel& pixel) {
@@ -223,28 +761,118 @@ void Renderer::draw_rectangle(const Coordinate& top_left, const Coordinate& bott
     draw_line(bottom_left, top_left, pixel);
 }
 
+void Renderer::draw_image(const std::span<const Pixel> image) {
+    if (image.size() != static_cast<size_t>(_width) * _height) {
+        throw std::runtime_error("Image size does not match the screen");
+    }
+    for (int y = 0; y < _height; ++y) {
+        for (int x = 0; x < _width; ++x) {
+            const Pixel& pixel = image[static_cast<size_t>(y) * _width + x];
+            if (_sample_count > 1) {
+                write_samples({ x, y }, (1u << _sample_count) - 1, pixel);
+            } else {
+                frame_pixel(x, y) = pixel;
+            }
+        }
+    }
+}
+
+void Renderer::draw_statistics_overlay() {
+    constexpr int line_height = (glyph_height + 1) * glyph_scale;
+    constexpr int graph_height = 40;
+    constexpr int panel_width = 240;
+    const auto& statistics = _statistics;
+
+    constexpr int line_count = 6 + static_cast<int>(Stage::Count);
+    const int panel_height = line_count * line_height + graph_height + 2 * glyph_scale;
+    for (int y = 0; y < std::min(panel_height, _height); ++y) {
+        for (int x = 0; x < std::min(panel_width, _width); ++x) {
+            plot({ x, y }, { 0, 0, 0 });
+        }
+    }
+
+    int line = 0;
+    const auto print = [&](const char* format, auto... arguments) {
+        std::array<char, 64> text;
+        std::snprintf(text.data(), text.size(), format, arguments...);
+        draw_text({ glyph_scale, glyph_scale + line++ * line_height }, text.data(), { 255, 255, 0 });
+    };
+    const auto count = [](const uint64_t value) { return static_cast<unsigned long long>(value); };
+    print("FRAME %.2f MS %.0f FPS", statistics.frame_time * 1000, statistics.frame_time > 0 ? 1 / statistics.frame_time : 0.0);
+    print("TRIS %llu IN %llu DRAWN", count(statistics.triangles_submitted), count(statistics.triangles_rasterised));
+    print("CULL %llu BACK %llu FRUSTUM", count(statistics.triangles_back_face_culled), count(statistics.triangles_frustum_culled));
+    print("CLIPPED %llu", count(statistics.triangles_clipped));
+    print("PIXELS %llu OVERDRAW %.2f", count(statistics.pixels_written), statistics.overdraw);
+    print("KERNELS %s", instruction_set_name(SimdKernels::active().instruction_set));
+    for (size_t i = 0; i < statistics.stage_times.size(); ++i) {
+        print("%-9s %.2f MS", stage_name(static_cast<Stage>(i)), statistics.stage_times[i] * 1000);
+    }
+
+    // Frame time graph, one pixel per millisecond, oldest frame on the left, with a 60 Hz marker
+    const int baseline = panel_height - 1;
+    for (size_t i = 0; i < _frame_times.size(); ++i) {
+        const double time = _frame_times[(_frame_time_index + i) % _frame_times.size()];
+        const int bar = std::min(static_cast<int>(time * 1000), graph_height - glyph_scale);
+        const Pixel colour = time > 1.0 / 30 ? Pixel{ 255, 0, 0 } : time > 1.0 / 60 ? Pixel{ 255, 255, 0 } : Pixel{ 0, 255, 0 };
+        for (int y = 0; y < bar; ++y) {
+            plot({ static_cast<int>(2 * i), baseline - y }, colour);
+            plot({ static_cast<int>(2 * i + 1), baseline - y }, colour);
+        }
+    }
+    for (int x = 0; x < panel_width; x += 4) {
+        plot({ x, baseline - 17 }, white);
+    }
+}
+
+void Renderer::draw_text(Coordinate position, const char* text, const Pixel& pixel) {
+    for (; *text != '\0'; ++text, position.x += (glyph_width + 1) * glyph_scale) {
+        const uint16_t bits = glyph(*text);
+        for (int row = 0; row < glyph_height; ++row) {
+            for (int column = 0; column < glyph_width; ++column) {
+                if (not (bits >> ((glyph_height - 1 - row) * glyph_width + glyph_width - 1 - column) & 1)) {
+                    continue;
+                }
+                for (int y = 0; y < glyph_scale; ++y) {
+                    for (int x = 0; x < glyph_scale; ++x) {
+                        plot({ position.x + column * glyph_scale + x, position.y + row * glyph_scale + y }, pixel);
+                    }
+                }
+            }
+        }
+    }
+}
+
 void Renderer::sleep(const int milliseconds) {
     SDL_Delay(milliseconds);
 }
 
+void Renderer::resolve() {
+    if (_sample_count == 1) {
+        return;
+    }
+    const auto& kernels = SimdKernels::active();
+    jobs().parallel_for("Resolve rows", _height, 16, [&](const size_t begin, const size_t end) {
+        kernels.resolve(&_samples[begin * _width * _sample_count], _sample_count, (end - begin) * _width, &_frame[begin * _width]);
+    });
+}
+
+void Renderer::capture(const std::span<Pixel> frame) const {
+    std::ranges::copy(_frame, frame.begin());
+}
+
+void Renderer::pack_frame(const std::span<uint32_t> screen) const {
+    for (size_t i = 0; i < _frame.size(); ++i) {
+        const Pixel& pixel = _frame[i];
+        screen[i] = pixel.red << 24 | pixel.green << 16 | pixel.blue << 8 | pixel.alpha;
+    }
+}
+
 void Renderer::render() {
     SDL_RenderClear(_renderer);
-    const auto pixels = new uint32_t[_width * _height];
-    for (int x = 0; x < _width; ++x) {
-        for (int y = 0; y < _height; ++y) {
-            pixels[x + y * _width] = _pixels[x][y].red << 24 | _pixels[x][y].green << 16 | _pixels[x][y].blue << 8 | _pixels[x][y].alpha;
-        }
+    if (not _idle) {
+        pack_frame(_screen_pixels);
+        SDL_UpdateTexture(_screen, nullptr, _screen_pixels.data(), _width * 4);
     }
-    SDL_UpdateTexture(_screen, nullptr, pixels, _width * 4);
-    delete[] pixels;
     SDL_RenderCopy(_renderer, _screen, nullptr, nullptr);
     SDL_RenderPresent(_renderer);
-    SDL_RenderSetLogicalSize(_renderer, _width, _height);
-    // SDL_RenderSetIntegerScale(_renderer, SDL_TRUE);
-}
-
-
-void Timer::start() { time.start = std::chrono::high_resolution_clock::now(); }
-void Timer::stop() { time.stop = std::chrono::high_resolution_clock::now(); }
-double Timer::elapsed() { return std::chrono::duration_cast<std::chrono::duration<double>>(time.stop - time.start).count(); }
-void Timer::restart() { time.start = time.stop; }
\ No newline at end of file
+}
\ No newline at end of file
@@ -1,6 +1,12 @@
 #pragma once
 
 #include "Coordinate.hpp"
+#include "FrameWriter.hpp"
+#include "JobSystem.hpp"
+#include "PipelineState.hpp"
+#include "Pixel.hpp"
+#include "SharedFrameRing.hpp"
+#include "Statistics.hpp"
 
 #include <SDL.h>
 
@@ -9,34 +15,84 @@
 #include <vector>
 #include <stdexcept>
 #include <chrono>
+#include <memory>
+#include <optional>
+#include <span>
 
 
 class Renderer {
 public:
-    Renderer(int width = 640, int height = 480, const std::string& title = "Window");
+    enum class Display : uint8_t {
+        Window,
+        Headless
+    };
+    Renderer(int width = 640, int height = 480, const std::string& title = "Window", Display = Display::Window);
     ~Renderer();
     void run();
+    void record(const std::string& path, FrameWriter::Format, int frame_rate = 30);
+    // Draws every new frame straight into a free slot of a shared memory ring for another process; see
+    // SharedFrameRing. A slot starts out holding an older frame, so update must draw the whole frame or keep_frame
+    void export_frames(const std::string& name, size_t slot_count = 3);
+    // Copies the last frame out row by row, into width() * height() pixels
+    void capture(std::span<Pixel>) const;
+    int width() const { return _width; }
+    int height() const { return _height; }
+    void set_frame_limit(int frames) { _frame_limit = frames; }
+    bool headless() const { return _display == Display::Headless; }
     virtual void initialise();
     virtual void update(double frame_time);
     virtual void close();
+    virtual void resize();
+    void set_sample_count(int samples);
+    int sample_count() const { return _sample_count; }
+    const FrameStatistics& statistics() const { return _statistics; }
+    void set_statistics_overlay(bool visible) { _statistics_overlay = visible; }
+    bool statistics_overlay() const { return _statistics_overlay; }
+    void set_dynamic_resolution(double target_frame_time, double minimum_scale = 0.5, double maximum_scale = 1);
+    double resolution_scale() const { return _resolution_scale; }
+    // Replaces the job system, which starts with the next frame, so only call it between frames
+    void configure_jobs(const JobSystem::Options&);
+    // Records a Chrome trace of every job for the whole run, written out when run returns
+    void trace(const std::string& path);
 protected:
-    struct Pixel {
-        uint8_t red;
-        uint8_t green;
-        uint8_t blue;
-        uint8_t alpha = 255;
-    };
     static constexpr Pixel white = { 255, 255, 255 };
+    // Pixels from minimum up to, but not including, maximum
+    struct Scissor {
+        Coordinate minimum;
+        Coordinate maximum;
+    };
+    Scissor screen() const { return { { 0, 0 }, { _width, _height } }; }
     void clear(const Pixel & = { 0, 0, 0 });
+    void clear(const Pixel&, const Scissor&);
     void draw_pixel(const Coordinate&, const Pixel & = white);
     void draw_line(const Coordinate&, const Coordinate&, const Pixel & = white);
     void draw_triangle(std::array<Coordinate, 3>, const Pixel & = white);
     void draw_filled_triangle(std::array<Coordinate, 3>, const Pixel & = white);
     void draw_rectangle(const Coordinate&, const Coordinate&, const Pixel & = white);
     void draw_circle(const Coordinate&, int radius, const Pixel & = white);
+    void draw_image(std::span<const Pixel>);
+    // Packs the last frame into RGBA8888 words row by row, as the screen texture takes them
+    void pack_frame(std::span<uint32_t>) const;
+    // Called from update when the framebuffer still holds this frame, so it is neither resolved nor uploaded again
+    void keep_frame() { _frame_kept = true; }
+    // Multisampled coverage works in 28.4 fixed point, sixteenths of a pixel
+    static constexpr int subpixel_bits = 4;
+    static constexpr int subpixel = 1 << subpixel_bits;
+    struct RasterTriangle {
+        std::array<Coordinate, 3> coordinates;
+        Pixel fill;
+        // The same corners in sixteenths of a pixel, where they are known that finely. Multisampled
+        // coverage uses them; single-sample fills and edges keep to whole pixels
+        std::optional<std::array<Coordinate, 3>> subpixel_coordinates = std::nullopt;
+    };
+    // Draws a batch with the kernel specialised for the fill mode and the current sample count;
+    // with edges, every interior is filled before any edge is drawn
+    void draw_triangles(std::span<const RasterTriangle>, PipelineState::Fill, const Pixel& edge = white);
+    // Only writes pixels inside the scissor, so threads can draw disjoint tiles at once
+    void draw_triangles(std::span<const RasterTriangle>, PipelineState::Fill, const Pixel& edge, const Scissor&);
+    JobSystem& jobs();
     void sleep(int milliseconds);
-    int width() const { return _width; }
-    int height() const { return _height; }
+    bool recording() const { return _frame_writer != nullptr; }
     bool _running = true;
     enum class ButtonState {
         Pressed,
@@ -63,33 +119,75 @@ protected:
     ButtonState key(char) const;
 private:
     void handle_events();
+    void govern_resolution();
+    void apply_resolution();
+    void draw_statistics_overlay();
+    void draw_text(Coordinate, const char* text, const Pixel&);
+    Scissor clip(const Scissor&) const;
+    bool plot(const Coordinate&, const Pixel&);
+    Pixel& frame_pixel(const int x, const int y) { return _frame[static_cast<size_t>(y) * _width + x]; }
+    void resolve();
     void render();
-    const int _width;
-    const int _height;
+    // Nothing but input, or an asset finishing loading, can change an idle frame
+    static constexpr int idle_wait_milliseconds = 50;
+    template <PipelineState state>
+    void rasterise(std::span<const RasterTriangle>, const Pixel& edge, const Scissor&);
+    template <PipelineState state>
+    uint64_t fill_triangle(std::array<Coordinate, 3>, const Pixel&, const Scissor&);
+    template <PipelineState state>
+    uint64_t fill_multisampled_triangle(std::array<Coordinate, 3>, const Pixel&, const Scissor&);
+    template <PipelineState state>
+    uint64_t draw_edge(const Coordinate&, const Coordinate&, const Pixel&, const Scissor&);
+    template <PipelineState state>
+    void write_samples(const Coordinate&, uint32_t coverage, const Pixel&);
+    void write_samples(const Coordinate&, uint32_t coverage, const Pixel&);
+    int _width;
+    int _height;
+    int _window_width;
+    int _window_height;
+    const Display _display;
     SDL_Window* _window = nullptr;
     SDL_Renderer* _renderer = nullptr;
     SDL_Texture* _screen = nullptr;
-    std::vector<std::vector<Pixel>> _pixels;
+    // Row by row. Frames are drawn into _frame, which is _pixels unless a ring slot is being drawn into
+    std::vector<Pixel> _pixels;
+    std::span<Pixel> _frame;
+    std::vector<uint32_t> _screen_pixels;
+    std::unique_ptr<FrameWriter> _frame_writer;
+    std::unique_ptr<SharedFrameRing> _frame_ring;
+    // Acquired from the ring and not yet submitted, or empty
+    std::span<Pixel> _frame_slot;
+    int _frame_limit = 0;
+    int _frame_count = 0;
+    int _sample_count = 1;
+    std::vector<Pixel> _samples;
     double _time_elapsed = 0;
+    FrameStatistics _statistics;
+    bool _statistics_overlay = false;
+    std::array<double, 120> _frame_times{};
+    size_t _frame_time_index = 0;
+    double _target_frame_time = 0;
+    double _minimum_scale = 0.5;
+    double _maximum_scale = 1;
+    double _resolution_scale = 1;
+    int _frames_over_budget = 0;
+    int _frames_under_budget = 0;
     Coordinate _mouse_position;
     std::array<ButtonState, 5> _mouse_buttons;
     std::array<ButtonState, 128> _keys;
+    // Declared before the job system, whose workers count into it until they are joined
+    Statistics::Collector _statistics_collector;
+    JobSystem::Options _job_options;
+    std::unique_ptr<JobSystem> _jobs;
+    std::string _trace_path;
+    double _render_time = 0;
+    bool _frame_kept = false;
+    // The last frame was kept with no overlay on top, so it is already resolved and on screen
+    bool _idle = false;
 };
 
 
 class SDLException final : public std::runtime_error {
 public:
     explicit SDLException(const std::string& message) : std::runtime_error(message + "(SDL_Error: " + std::string(SDL_GetError()) + ")\n") {}
-};
-
-
-namespace Timer {
-    void start();
-    void stop();
-    double elapsed();
-    void restart();
-    static struct {
-        std::chrono::high_resolution_clock::time_point start;
-        std::chrono::high_resolution_clock::time_point stop;
-    } time;
 };
\ No newline at end of file
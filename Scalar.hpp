@@ -0,0 +1,15 @@
+#pragma once
+
+
+// The math types default to single precision, which halves the memory the geometry stage moves
+// and lets a vector sit in one SSE register. Define RENDERER_DOUBLE_PRECISION for a double build
+#ifdef RENDERER_DOUBLE_PRECISION
+using Scalar = double;
+#else
+using Scalar = float;
+#endif
+
+#if defined(__SSE2__) or defined(_M_X64) or (defined(_M_IX86_FP) and _M_IX86_FP >= 2)
+#define RENDERER_SSE
+#include <emmintrin.h>
+#endif
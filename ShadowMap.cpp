@@ -0,0 +1,84 @@
+#include "ShadowMap.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+
+ShadowMap::ShadowMap(const int resolution) : _resolution(resolution), _depth(static_cast<size_t>(resolution) * resolution, 1.0f) {}
+
+void ShadowMap::begin(const Matrix4x4& light_matrix) {
+    _matrix = light_matrix;
+    std::ranges::fill(_depth, 1.0f);
+}
+
+void ShadowMap::draw_triangle(const Matrix4x4& transform, const std::array<Vector3D, 3>& vertices) {
+    const float scale = _resolution * 0.5f;
+
+    // The light projection is affine, so w is always 1 and only three rows are needed
+    std::array<float, 3> x, y, z;
+    for (size_t i = 0; i < 3; ++i) {
+        const Vector3D& vertex = vertices[i];
+        x[i] = static_cast<float>((transform[0][0] * vertex.x + transform[0][1] * vertex.y + transform[0][2] * vertex.z + transform[0][3] + 1) * scale);
+        y[i] = static_cast<float>((transform[1][0] * vertex.x + transform[1][1] * vertex.y + transform[1][2] * vertex.z + transform[1][3] + 1) * scale);
+        z[i] = static_cast<float>(transform[2][0] * vertex.x + transform[2][1] * vertex.y + transform[2][2] * vertex.z + transform[2][3]);
+    }
+
+    const float area = (x[1] - x[0]) * (y[2] - y[0]) - (y[1] - y[0]) * (x[2] - x[0]);
+    if (area >= 0) {
+        return;
+    }
+
+    const int min_x = std::max(static_cast<int>(std::min({ x[0], x[1], x[2] })), 0);
+    const int min_y = std::max(static_cast<int>(std::min({ y[0], y[1], y[2] })), 0);
+    const int max_x = std::min(static_cast<int>(std::max({ x[0], x[1], x[2] })), _resolution - 1);
+    const int max_y = std::min(static_cast<int>(std::max({ y[0], y[1], y[2] })), _resolution - 1);
+    if (min_x > max_x or min_y > max_y) {
+        return;
+    }
+
+    // Edge functions and depth are affine in texel space, so each steps with a single add per texel
+    const float start_x = min_x + 0.5f;
+    const float start_y = min_y + 0.5f;
+    std::array<float, 3> step_x, step_y, row;
+    float depth_step_x = 0;
+    float depth_step_y = 0;
+    float depth_row = 0;
+    for (size_t i = 0; i < 3; ++i) {
+        const size_t from = (i + 1) % 3;
+        const size_t to = (i + 2) % 3;
+        step_x[i] = (y[to] - y[from]) / -area;
+        step_y[i] = (x[from] - x[to]) / -area;
+        row[i] = step_x[i] * (start_x - x[from]) + step_y[i] * (start_y - y[from]);
+        depth_step_x += step_x[i] * z[i];
+        depth_step_y += step_y[i] * z[i];
+        depth_row += row[i] * z[i];
+    }
+
+    for (int texel_y = min_y; texel_y <= max_y; ++texel_y) {
+        float* const depths = _depth.data() + static_cast<size_t>(texel_y) * _resolution;
+        float w0 = row[0], w1 = row[1], w2 = row[2];
+        float depth = depth_row;
+        for (int texel_x = min_x; texel_x <= max_x; ++texel_x) {
+            const bool inside = (w0 >= 0) & (w1 >= 0) & (w2 >= 0);
+            depths[texel_x] = inside and depth < depths[texel_x] ? depth : depths[texel_x];
+            w0 += step_x[0];
+            w1 += step_x[1];
+            w2 += step_x[2];
+            depth += depth_step_x;
+        }
+        for (size_t i = 0; i < 3; ++i) {
+            row[i] += step_y[i];
+        }
+        depth_row += depth_step_y;
+    }
+}
+
+double ShadowMap::visibility(const Vector3D& light_position) const {
+    constexpr double bias = 0.002;
+    const int x = static_cast<int>(std::floor((light_position.x + 1) * 0.5 * _resolution));
+    const int y = static_cast<int>(std::floor((light_position.y + 1) * 0.5 * _resolution));
+    if (x < 0 or x >= _resolution or y < 0 or y >= _resolution or light_position.z > 1) {
+        return 1;
+    }
+    return light_position.z - bias <= _depth[static_cast<size_t>(y) * _resolution + x] ? 1 : 0;
+}
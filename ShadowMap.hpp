@@ -0,0 +1,32 @@
+#pragma once
+
+#include "Matrix4x4.hpp"
+#include "Vector3D.hpp"
+
+#include <array>
+#include <vector>
+
+
+// Depth-only render of the scene from a directional light. Positions are mapped into the
+// light's clip space by matrix(), where x and y span [-1, 1] and z spans [0, 1]
+class ShadowMap {
+public:
+    explicit ShadowMap(int resolution);
+
+    void begin(const Matrix4x4& light_matrix);
+    const Matrix4x4& matrix() const { return _matrix; }
+
+    // Transforms by `transform` (object to light clip space) and writes depth only.
+    // Triangles facing the light are skipped: the back faces are enough to occlude,
+    // and comparing against them keeps lit surfaces free of self-shadowing
+    void draw_triangle(const Matrix4x4& transform, const std::array<Vector3D, 3>& vertices);
+
+    // 1 when the light-clip-space position is lit, 0 when it is occluded
+    double visibility(const Vector3D& light_position) const;
+
+    int resolution() const { return _resolution; }
+private:
+    int _resolution;
+    Matrix4x4 _matrix = make_identity_matrix();
+    std::vector<float> _depth;
+};
@@ -0,0 +1,197 @@
+#include "SharedFrameRing.hpp"
+
+#include <cstring>
+#include <stdexcept>
+
+#ifndef _WIN32
+#include <cerrno>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+
+static_assert(sizeof(Pixel) == 4, "Slots hold Pixel memory as RGBA8");
+
+
+namespace {
+    constexpr size_t slot_alignment = 64;
+
+    std::string shared_name(const std::string& name) {
+        return name.starts_with('/') ? name : '/' + name;
+    }
+
+    std::runtime_error system_error(const std::string& message) {
+#ifdef _WIN32
+        return std::runtime_error(message + " (shared frame rings need POSIX shared memory)");
+#else
+        return std::runtime_error(message + " (" + std::strerror(errno) + ")");
+#endif
+    }
+
+    SharedFrameRing::Slot& slot_at(SharedFrameRing::Header* header, const uint64_t index) {
+        auto* const base = reinterpret_cast<std::byte*>(header) + sizeof(SharedFrameRing::Header);
+        return *reinterpret_cast<SharedFrameRing::Slot*>(base + (index % header->slot_count) * header->slot_size);
+    }
+
+    Pixel* pixels_of(SharedFrameRing::Slot& slot) {
+        return reinterpret_cast<Pixel*>(&slot + 1);
+    }
+
+    int64_t nanoseconds(const std::chrono::steady_clock::time_point time) {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(time.time_since_epoch()).count();
+    }
+}
+
+
+SharedFrameRing::SharedFrameRing(const std::string& name, const int width, const int height, const size_t slot_count) : _name(shared_name(name)) {
+    if (width <= 0 or height <= 0 or slot_count == 0) {
+        throw std::runtime_error("Invalid shared frame ring dimensions");
+    }
+    const size_t frame_size = sizeof(Slot) + static_cast<size_t>(width) * height * sizeof(Pixel);
+    const size_t slot_size = (frame_size + slot_alignment - 1) / slot_alignment * slot_alignment;
+    _size = sizeof(Header) + slot_size * slot_count;
+
+#ifdef _WIN32
+    throw system_error("Could not create shared frame ring " + _name);
+#else
+    // A fresh object, so that a consumer still mapping an old one is never truncated under it
+    shm_unlink(_name.c_str());
+    const int file = shm_open(_name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0600);
+    if (file < 0) {
+        throw system_error("Could not create shared frame ring " + _name);
+    }
+    if (ftruncate(file, static_cast<off_t>(_size)) != 0) {
+        close(file);
+        shm_unlink(_name.c_str());
+        throw system_error("Could not size shared frame ring " + _name);
+    }
+    void* const memory = mmap(nullptr, _size, PROT_READ | PROT_WRITE, MAP_SHARED, file, 0);
+    close(file);
+    if (memory == MAP_FAILED) {
+        shm_unlink(_name.c_str());
+        throw system_error("Could not map shared frame ring " + _name);
+    }
+    // The new object is zero filled, which is a valid state for every atomic
+    _header = static_cast<Header*>(memory);
+#endif
+
+    _header->version = version;
+    _header->slot_count = static_cast<uint32_t>(slot_count);
+    _header->width = static_cast<uint32_t>(width);
+    _header->height = static_cast<uint32_t>(height);
+    _header->format = Format::RGBA8;
+    _header->slot_size = slot_size;
+    for (uint64_t i = 0; i < slot_count; ++i) {
+        Slot& slot = slot_at(_header, i);
+        slot.width = _header->width;
+        slot.height = _header->height;
+        slot.format = Format::RGBA8;
+        slot.stride = static_cast<uint32_t>(width * sizeof(Pixel));
+    }
+    _header->magic.store(magic, std::memory_order_release);
+}
+
+SharedFrameRing::~SharedFrameRing() {
+#ifndef _WIN32
+    _header->closed.store(1, std::memory_order_release);
+    munmap(_header, _size);
+    shm_unlink(_name.c_str());
+#endif
+}
+
+std::span<Pixel> SharedFrameRing::acquire() {
+    if (_acquired) {
+        throw std::runtime_error("Shared frame acquired twice without being submitted");
+    }
+    const uint64_t produced = _header->produced.load(std::memory_order_relaxed);
+    // Acquire, so the consumer's reads of the slot are finished before it is overwritten
+    if (produced - _header->consumed.load(std::memory_order_acquire) >= _header->slot_count) {
+        return {};
+    }
+    _acquired = true;
+    return { pixels_of(slot_at(_header, produced)), static_cast<size_t>(_header->width) * _header->height };
+}
+
+void SharedFrameRing::submit(const std::chrono::steady_clock::time_point render_start) {
+    if (not _acquired) {
+        throw std::runtime_error("Shared frame submitted without being acquired");
+    }
+    _acquired = false;
+    const uint64_t produced = _header->produced.load(std::memory_order_relaxed);
+    Slot& slot = slot_at(_header, produced);
+    slot.frame_number = _frame_number++;
+    slot.render_start = nanoseconds(render_start);
+    slot.published = nanoseconds(std::chrono::steady_clock::now());
+    _header->produced.store(produced + 1, std::memory_order_release);
+}
+
+void SharedFrameRing::drop() {
+    _header->dropped.fetch_add(1, std::memory_order_relaxed);
+    ++_frame_number;
+}
+
+
+SharedFrameRing::Reader::Reader(const std::string& name) {
+#ifdef _WIN32
+    throw system_error("Could not open shared frame ring " + shared_name(name));
+#else
+    const std::string path = shared_name(name);
+    const int file = shm_open(path.c_str(), O_RDWR, 0);
+    if (file < 0) {
+        throw system_error("Could not open shared frame ring " + path);
+    }
+    struct stat status;
+    if (fstat(file, &status) != 0 or static_cast<size_t>(status.st_size) < sizeof(Header)) {
+        close(file);
+        throw std::runtime_error("Shared frame ring " + path + " is not ready");
+    }
+    _size = static_cast<size_t>(status.st_size);
+    void* const memory = mmap(nullptr, _size, PROT_READ | PROT_WRITE, MAP_SHARED, file, 0);
+    close(file);
+    if (memory == MAP_FAILED) {
+        throw system_error("Could not map shared frame ring " + path);
+    }
+    _header = static_cast<Header*>(memory);
+
+    if (_header->magic.load(std::memory_order_acquire) != magic or _header->version != version
+        or _size < sizeof(Header) + _header->slot_size * _header->slot_count) {
+        munmap(_header, _size);
+        throw std::runtime_error("Shared frame ring " + path + " is not ready or has an unknown layout");
+    }
+#endif
+}
+
+SharedFrameRing::Reader::~Reader() {
+#ifndef _WIN32
+    munmap(_header, _size);
+#endif
+}
+
+std::optional<SharedFrameRing::Reader::Frame> SharedFrameRing::Reader::acquire() {
+    if (_acquired) {
+        throw std::runtime_error("Shared frame acquired twice without being released");
+    }
+    const uint64_t consumed = _header->consumed.load(std::memory_order_relaxed);
+    if (_header->produced.load(std::memory_order_acquire) == consumed) {
+        return std::nullopt;
+    }
+    _acquired = true;
+    Slot& slot = slot_at(_header, consumed);
+    return Frame{ slot, { pixels_of(slot), static_cast<size_t>(slot.width) * slot.height } };
+}
+
+void SharedFrameRing::Reader::release() {
+    if (not _acquired) {
+        throw std::runtime_error("Shared frame released without being acquired");
+    }
+    _acquired = false;
+    _header->consumed.store(_header->consumed.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+}
+
+bool SharedFrameRing::Reader::finished() const {
+    // Closed is set after the last publish, so seeing it first means produced is final
+    return _header->closed.load(std::memory_order_acquire) != 0
+        and _header->produced.load(std::memory_order_acquire) == _header->consumed.load(std::memory_order_relaxed);
+}
@@ -0,0 +1,106 @@
+#pragma once
+
+#include "Pixel.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <span>
+#include <string>
+
+
+// Hands finished frames to another local process through a POSIX shared memory object, which holds
+// a Header and then slot_count slots, each a Slot followed by its pixels. The producer fills slots in
+// order and publishes each by advancing produced; the consumer reads the oldest unread slot in place
+// and frees it by advancing consumed. With one of each, neither side takes a lock. When the consumer
+// is a whole ring behind, frames are dropped instead of stalling the renderer, leaving gaps in frame_number
+class SharedFrameRing {
+public:
+    enum class Format : uint32_t {
+        RGBA8 = 1 // Pixel as laid out in memory: red, green, blue, alpha
+    };
+
+    static constexpr uint32_t magic = 0x31524653; // "SFR1"
+    static constexpr uint32_t version = 1;
+
+    struct Header {
+        // Set last, once everything else is in place
+        std::atomic<uint32_t> magic;
+        uint32_t version;
+        uint32_t slot_count;
+        uint32_t width;
+        uint32_t height;
+        Format format;
+        // Bytes from one slot to the next; the first starts at sizeof(Header)
+        uint64_t slot_size;
+        // Written by the producer only. Frame i of those published is in slot i % slot_count
+        alignas(64) std::atomic<uint64_t> produced;
+        std::atomic<uint64_t> dropped;
+        std::atomic<uint32_t> closed;
+        // Written by the consumer only
+        alignas(64) std::atomic<uint64_t> consumed;
+    };
+
+    struct alignas(64) Slot {
+        uint64_t frame_number;
+        uint32_t width;
+        uint32_t height;
+        Format format;
+        // Bytes per row
+        uint32_t stride;
+        // Steady clock nanoseconds, which on Linux is CLOCK_MONOTONIC and so comparable between processes
+        int64_t render_start;
+        int64_t published;
+    };
+
+    static_assert(std::atomic<uint64_t>::is_always_lock_free, "The indices are shared between processes");
+
+    // Replaces any object already under name, which POSIX wants to start with a slash
+    SharedFrameRing(const std::string& name, int width, int height, size_t slot_count = 3);
+    // Marks the ring closed and unlinks it; consumers keep their mapping
+    ~SharedFrameRing();
+    SharedFrameRing(const SharedFrameRing&) = delete;
+    SharedFrameRing& operator=(const SharedFrameRing&) = delete;
+
+    // The next free slot, row by row, to draw the frame straight into, or an empty span while the consumer
+    // is a whole ring behind. The slot may be held across frames until one is submitted
+    std::span<Pixel> acquire();
+    void submit(std::chrono::steady_clock::time_point render_start);
+    // Counts a frame that found no free slot, so it never reaches the consumer
+    void drop();
+
+    uint64_t dropped() const { return _header->dropped.load(std::memory_order_relaxed); }
+
+    // The consumer side, for processes that read the ring
+    class Reader {
+    public:
+        explicit Reader(const std::string& name);
+        ~Reader();
+        Reader(const Reader&) = delete;
+        Reader& operator=(const Reader&) = delete;
+
+        struct Frame {
+            const Slot& slot;
+            std::span<const Pixel> pixels;
+        };
+        // The oldest unread frame, which stays untouched by the producer until release
+        std::optional<Frame> acquire();
+        void release();
+
+        const Header& header() const { return *_header; }
+        // The producer has gone and every frame it published has been read
+        bool finished() const;
+    private:
+        Header* _header = nullptr;
+        size_t _size = 0;
+        bool _acquired = false;
+    };
+private:
+    std::string _name;
+    Header* _header = nullptr;
+    size_t _size = 0;
+    uint64_t _frame_number = 0;
+    bool _acquired = false;
+};
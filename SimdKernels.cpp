@@ -0,0 +1,312 @@
+#include "SimdKernels.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <cstdint>
+
+#ifdef RENDERER_X86
+#include <immintrin.h>
+#endif
+
+
+static_assert(sizeof(Pixel) == 4, "Kernels treat a pixel as one 32-bit lane");
+
+
+namespace {
+    void fill_scalar(Pixel* const destination, const size_t count, const Pixel pixel) {
+        std::fill_n(destination, count, pixel);
+    }
+
+    void resolve_scalar(const Pixel* samples, const int sample_count, const size_t pixel_count, Pixel* const resolved) {
+        for (size_t p = 0; p < pixel_count; ++p, samples += sample_count) {
+            int red = 0, green = 0, blue = 0, alpha = 0;
+            for (int s = 0; s < sample_count; ++s) {
+                red += samples[s].red;
+                green += samples[s].green;
+                blue += samples[s].blue;
+                alpha += samples[s].alpha;
+            }
+            resolved[p] = {
+                static_cast<uint8_t>(red / sample_count),
+                static_cast<uint8_t>(green / sample_count),
+                static_cast<uint8_t>(blue / sample_count),
+                static_cast<uint8_t>(alpha / sample_count)
+            };
+        }
+    }
+
+    // Sums are paired the same way as the inline SSE matrix product, so every path agrees to the bit
+    void transform_scalar(const float* const matrix, const float* points, float* transformed, const size_t count) {
+        for (size_t i = 0; i < count; ++i, points += 4, transformed += 4) {
+            const float x = points[0], y = points[1], z = points[2], w = points[3];
+            for (size_t row = 0; row < 4; ++row) {
+                const float* const m = matrix + 4 * row;
+                transformed[row] = (m[0] * x + m[1] * y) + (m[2] * z + m[3] * w);
+            }
+        }
+    }
+
+    // The vector paths evaluate these same operations in the same order, lane by lane
+    void shade_lights_scalar(const ShadingRow& row, const ShadingLight* const lights, const uint32_t* const indices, const size_t index_count) {
+        for (size_t l = 0; l < index_count; ++l) {
+            const ShadingLight& light = lights[indices[l]];
+            for (size_t i = 0; i < row.count; ++i) {
+                const float lx = light.x - row.x[i];
+                const float ly = light.y - row.y[i];
+                const float lz = light.z - row.z[i];
+                const float distance_squared = lx * lx + ly * ly + lz * lz + 1e-6f;
+                const float falloff = std::max(0.0f, 1 - distance_squared * light.inverse_radius_squared);
+                const float incidence = std::max(0.0f, (row.normal_x[i] * lx + row.normal_y[i] * ly + row.normal_z[i] * lz) / std::sqrt(distance_squared));
+                const float intensity = falloff * falloff * incidence;
+                row.red[i] += light.red * intensity;
+                row.green[i] += light.green * intensity;
+                row.blue[i] += light.blue * intensity;
+            }
+        }
+    }
+
+#ifdef RENDERER_X86
+    RENDERER_TARGET("sse2")
+    void fill_sse2(Pixel* const destination, const size_t count, const Pixel pixel) {
+        const __m128i value = _mm_set1_epi32(std::bit_cast<int32_t>(pixel));
+        size_t i = 0;
+        for (; i + 4 <= count; i += 4) {
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(destination + i), value);
+        }
+        std::fill(destination + i, destination + count, pixel);
+    }
+
+    RENDERER_TARGET("sse2")
+    void resolve_sse2(const Pixel* samples, const int sample_count, const size_t pixel_count, Pixel* const resolved) {
+        const __m128i zero = _mm_setzero_si128();
+        const __m128i shift = _mm_cvtsi32_si128(std::countr_zero(static_cast<unsigned>(sample_count)));
+        for (size_t p = 0; p < pixel_count; ++p, samples += sample_count) {
+            // Channels widen to 16 bits, two samples to a register, then the halves are folded together
+            __m128i sum;
+            if (sample_count == 2) {
+                sum = _mm_unpacklo_epi8(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(samples)), zero);
+            } else {
+                sum = zero;
+                for (int s = 0; s < sample_count; s += 4) {
+                    const __m128i four = _mm_loadu_si128(reinterpret_cast<const __m128i*>(samples + s));
+                    sum = _mm_add_epi16(sum, _mm_add_epi16(_mm_unpacklo_epi8(four, zero), _mm_unpackhi_epi8(four, zero)));
+                }
+            }
+            sum = _mm_add_epi16(sum, _mm_srli_si128(sum, 8));
+            resolved[p] = std::bit_cast<Pixel>(_mm_cvtsi128_si32(_mm_packus_epi16(_mm_srl_epi16(sum, shift), zero)));
+        }
+    }
+
+    RENDERER_TARGET("sse2")
+    void transform_sse2(const float* const matrix, const float* points, float* transformed, const size_t count) {
+        // Columns, so that each point is a weighted sum of four registers
+        const __m128 column_x = _mm_setr_ps(matrix[0], matrix[4], matrix[8], matrix[12]);
+        const __m128 column_y = _mm_setr_ps(matrix[1], matrix[5], matrix[9], matrix[13]);
+        const __m128 column_z = _mm_setr_ps(matrix[2], matrix[6], matrix[10], matrix[14]);
+        const __m128 column_w = _mm_setr_ps(matrix[3], matrix[7], matrix[11], matrix[15]);
+        for (size_t i = 0; i < count; ++i, points += 4, transformed += 4) {
+            const __m128 point = _mm_load_ps(points);
+            const __m128 x = _mm_mul_ps(column_x, _mm_shuffle_ps(point, point, 0x00));
+            const __m128 y = _mm_mul_ps(column_y, _mm_shuffle_ps(point, point, 0x55));
+            const __m128 z = _mm_mul_ps(column_z, _mm_shuffle_ps(point, point, 0xaa));
+            const __m128 w = _mm_mul_ps(column_w, _mm_shuffle_ps(point, point, 0xff));
+            _mm_store_ps(transformed, _mm_add_ps(_mm_add_ps(x, y), _mm_add_ps(z, w)));
+        }
+    }
+
+    // Four pixels at a time; max takes the zero second, as std::max does, so a NaN becomes zero on every path
+    RENDERER_TARGET("sse2")
+    void shade_lights_sse2(const ShadingRow& row, const ShadingLight* const lights, const uint32_t* const indices, const size_t index_count) {
+        const size_t vector_count = row.count / 4 * 4;
+        const __m128 zero = _mm_setzero_ps();
+        const __m128 one = _mm_set1_ps(1);
+        const __m128 epsilon = _mm_set1_ps(1e-6f);
+        for (size_t l = 0; l < index_count; ++l) {
+            const ShadingLight& light = lights[indices[l]];
+            for (size_t i = 0; i < vector_count; i += 4) {
+                const __m128 lx = _mm_sub_ps(_mm_set1_ps(light.x), _mm_loadu_ps(row.x + i));
+                const __m128 ly = _mm_sub_ps(_mm_set1_ps(light.y), _mm_loadu_ps(row.y + i));
+                const __m128 lz = _mm_sub_ps(_mm_set1_ps(light.z), _mm_loadu_ps(row.z + i));
+                const __m128 distance_squared = _mm_add_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(lx, lx), _mm_mul_ps(ly, ly)), _mm_mul_ps(lz, lz)), epsilon);
+                const __m128 falloff = _mm_max_ps(_mm_sub_ps(one, _mm_mul_ps(distance_squared, _mm_set1_ps(light.inverse_radius_squared))), zero);
+                const __m128 facing = _mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_loadu_ps(row.normal_x + i), lx), _mm_mul_ps(_mm_loadu_ps(row.normal_y + i), ly)), _mm_mul_ps(_mm_loadu_ps(row.normal_z + i), lz));
+                const __m128 incidence = _mm_max_ps(_mm_div_ps(facing, _mm_sqrt_ps(distance_squared)), zero);
+                const __m128 intensity = _mm_mul_ps(_mm_mul_ps(falloff, falloff), incidence);
+                _mm_storeu_ps(row.red + i, _mm_add_ps(_mm_loadu_ps(row.red + i), _mm_mul_ps(_mm_set1_ps(light.red), intensity)));
+                _mm_storeu_ps(row.green + i, _mm_add_ps(_mm_loadu_ps(row.green + i), _mm_mul_ps(_mm_set1_ps(light.green), intensity)));
+                _mm_storeu_ps(row.blue + i, _mm_add_ps(_mm_loadu_ps(row.blue + i), _mm_mul_ps(_mm_set1_ps(light.blue), intensity)));
+            }
+        }
+        if (vector_count < row.count) {
+            const ShadingRow rest = {
+                row.x + vector_count, row.y + vector_count, row.z + vector_count,
+                row.normal_x + vector_count, row.normal_y + vector_count, row.normal_z + vector_count,
+                row.red + vector_count, row.green + vector_count, row.blue + vector_count, row.count - vector_count
+            };
+            shade_lights_scalar(rest, lights, indices, index_count);
+        }
+    }
+
+    RENDERER_TARGET("avx2")
+    void fill_avx2(Pixel* const destination, const size_t count, const Pixel pixel) {
+        const __m256i value = _mm256_set1_epi32(std::bit_cast<int32_t>(pixel));
+        size_t i = 0;
+        for (; i + 8 <= count; i += 8) {
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(destination + i), value);
+        }
+        std::fill(destination + i, destination + count, pixel);
+    }
+
+    // Each 32-byte load holds eight samples, which is 8 / sample_count whole pixels
+    template <int sample_count>
+    RENDERER_TARGET("avx2")
+    size_t resolve_avx2(const Pixel* const samples, const size_t pixel_count, Pixel* const resolved) {
+        constexpr size_t pixels_per_load = 8 / sample_count;
+        const __m128i zero = _mm_setzero_si128();
+        const __m128i shift = _mm_cvtsi32_si128(std::countr_zero(static_cast<unsigned>(sample_count)));
+        size_t p = 0;
+        for (; p + pixels_per_load <= pixel_count; p += pixels_per_load) {
+            const __m256i eight = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(samples + p * sample_count));
+            __m256i low = _mm256_cvtepu8_epi16(_mm256_castsi256_si128(eight));
+            __m256i high = _mm256_cvtepu8_epi16(_mm256_extracti128_si256(eight, 1));
+            if constexpr (sample_count == 8) {
+                low = _mm256_add_epi16(low, high);
+            }
+            // Fold neighbouring samples, leaving one pair sum per 128-bit lane
+            low = _mm256_add_epi16(low, _mm256_shuffle_epi32(low, _MM_SHUFFLE(1, 0, 3, 2)));
+            high = _mm256_add_epi16(high, _mm256_shuffle_epi32(high, _MM_SHUFFLE(1, 0, 3, 2)));
+
+            if constexpr (sample_count == 2) {
+                const __m128i first = _mm256_castsi256_si128(_mm256_permute4x64_epi64(low, _MM_SHUFFLE(3, 1, 2, 0)));
+                const __m128i second = _mm256_castsi256_si128(_mm256_permute4x64_epi64(high, _MM_SHUFFLE(3, 1, 2, 0)));
+                const __m128i packed = _mm_packus_epi16(_mm_srl_epi16(first, shift), _mm_srl_epi16(second, shift));
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(resolved + p), packed);
+            } else {
+                low = _mm256_add_epi16(low, _mm256_permute2x128_si256(low, low, 1));
+                if constexpr (sample_count == 4) {
+                    high = _mm256_add_epi16(high, _mm256_permute2x128_si256(high, high, 1));
+                    const __m128i both = _mm_unpacklo_epi64(_mm256_castsi256_si128(low), _mm256_castsi256_si128(high));
+                    _mm_storel_epi64(reinterpret_cast<__m128i*>(resolved + p), _mm_packus_epi16(_mm_srl_epi16(both, shift), zero));
+                } else {
+                    resolved[p] = std::bit_cast<Pixel>(_mm_cvtsi128_si32(_mm_packus_epi16(_mm_srl_epi16(_mm256_castsi256_si128(low), shift), zero)));
+                }
+            }
+        }
+        return p;
+    }
+
+    RENDERER_TARGET("avx2")
+    void resolve_avx2(const Pixel* const samples, const int sample_count, const size_t pixel_count, Pixel* const resolved) {
+        size_t done = 0;
+        switch (sample_count) {
+            case 2: done = resolve_avx2<2>(samples, pixel_count, resolved); break;
+            case 4: done = resolve_avx2<4>(samples, pixel_count, resolved); break;
+            case 8: done = resolve_avx2<8>(samples, pixel_count, resolved); break;
+        }
+        resolve_sse2(samples + done * sample_count, sample_count, pixel_count - done, resolved + done);
+    }
+
+    RENDERER_TARGET("avx2")
+    void transform_avx2(const float* const matrix, const float* points, float* transformed, const size_t count) {
+        // Two points per register, each in its own 128-bit lane
+        const __m256 column_x = _mm256_setr_ps(matrix[0], matrix[4], matrix[8], matrix[12], matrix[0], matrix[4], matrix[8], matrix[12]);
+        const __m256 column_y = _mm256_setr_ps(matrix[1], matrix[5], matrix[9], matrix[13], matrix[1], matrix[5], matrix[9], matrix[13]);
+        const __m256 column_z = _mm256_setr_ps(matrix[2], matrix[6], matrix[10], matrix[14], matrix[2], matrix[6], matrix[10], matrix[14]);
+        const __m256 column_w = _mm256_setr_ps(matrix[3], matrix[7], matrix[11], matrix[15], matrix[3], matrix[7], matrix[11], matrix[15]);
+        size_t i = 0;
+        for (; i + 2 <= count; i += 2, points += 8, transformed += 8) {
+            const __m256 two = _mm256_loadu_ps(points);
+            const __m256 x = _mm256_mul_ps(column_x, _mm256_permute_ps(two, 0x00));
+            const __m256 y = _mm256_mul_ps(column_y, _mm256_permute_ps(two, 0x55));
+            const __m256 z = _mm256_mul_ps(column_z, _mm256_permute_ps(two, 0xaa));
+            const __m256 w = _mm256_mul_ps(column_w, _mm256_permute_ps(two, 0xff));
+            _mm256_storeu_ps(transformed, _mm256_add_ps(_mm256_add_ps(x, y), _mm256_add_ps(z, w)));
+        }
+        transform_sse2(matrix, points, transformed, count - i);
+    }
+
+    RENDERER_TARGET("avx2")
+    void shade_lights_avx2(const ShadingRow& row, const ShadingLight* const lights, const uint32_t* const indices, const size_t index_count) {
+        const size_t vector_count = row.count / 8 * 8;
+        const __m256 zero = _mm256_setzero_ps();
+        const __m256 one = _mm256_set1_ps(1);
+        const __m256 epsilon = _mm256_set1_ps(1e-6f);
+        for (size_t l = 0; l < index_count; ++l) {
+            const ShadingLight& light = lights[indices[l]];
+            for (size_t i = 0; i < vector_count; i += 8) {
+                const __m256 lx = _mm256_sub_ps(_mm256_set1_ps(light.x), _mm256_loadu_ps(row.x + i));
+                const __m256 ly = _mm256_sub_ps(_mm256_set1_ps(light.y), _mm256_loadu_ps(row.y + i));
+                const __m256 lz = _mm256_sub_ps(_mm256_set1_ps(light.z), _mm256_loadu_ps(row.z + i));
+                const __m256 distance_squared = _mm256_add_ps(_mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(lx, lx), _mm256_mul_ps(ly, ly)), _mm256_mul_ps(lz, lz)), epsilon);
+                const __m256 falloff = _mm256_max_ps(_mm256_sub_ps(one, _mm256_mul_ps(distance_squared, _mm256_set1_ps(light.inverse_radius_squared))), zero);
+                const __m256 facing = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(_mm256_loadu_ps(row.normal_x + i), lx), _mm256_mul_ps(_mm256_loadu_ps(row.normal_y + i), ly)), _mm256_mul_ps(_mm256_loadu_ps(row.normal_z + i), lz));
+                const __m256 incidence = _mm256_max_ps(_mm256_div_ps(facing, _mm256_sqrt_ps(distance_squared)), zero);
+                const __m256 intensity = _mm256_mul_ps(_mm256_mul_ps(falloff, falloff), incidence);
+                _mm256_storeu_ps(row.red + i, _mm256_add_ps(_mm256_loadu_ps(row.red + i), _mm256_mul_ps(_mm256_set1_ps(light.red), intensity)));
+                _mm256_storeu_ps(row.green + i, _mm256_add_ps(_mm256_loadu_ps(row.green + i), _mm256_mul_ps(_mm256_set1_ps(light.green), intensity)));
+                _mm256_storeu_ps(row.blue + i, _mm256_add_ps(_mm256_loadu_ps(row.blue + i), _mm256_mul_ps(_mm256_set1_ps(light.blue), intensity)));
+            }
+        }
+        if (vector_count < row.count) {
+            const ShadingRow rest = {
+                row.x + vector_count, row.y + vector_count, row.z + vector_count,
+                row.normal_x + vector_count, row.normal_y + vector_count, row.normal_z + vector_count,
+                row.red + vector_count, row.green + vector_count, row.blue + vector_count, row.count - vector_count
+            };
+            shade_lights_sse2(rest, lights, indices, index_count);
+        }
+    }
+
+    RENDERER_TARGET("avx512f")
+    void fill_avx512(Pixel* const destination, const size_t count, const Pixel pixel) {
+        const __m512i value = _mm512_set1_epi32(std::bit_cast<int32_t>(pixel));
+        size_t i = 0;
+        for (; i + 16 <= count; i += 16) {
+            _mm512_storeu_si512(destination + i, value);
+        }
+        const __mmask16 remainder = static_cast<__mmask16>((1u << (count - i)) - 1);
+        _mm512_mask_storeu_epi32(destination + i, remainder, value);
+    }
+
+    RENDERER_TARGET("avx512f")
+    void transform_avx512(const float* const matrix, const float* points, float* transformed, const size_t count) {
+        // Four points per register
+        const __m512 column_x = _mm512_setr4_ps(matrix[0], matrix[4], matrix[8], matrix[12]);
+        const __m512 column_y = _mm512_setr4_ps(matrix[1], matrix[5], matrix[9], matrix[13]);
+        const __m512 column_z = _mm512_setr4_ps(matrix[2], matrix[6], matrix[10], matrix[14]);
+        const __m512 column_w = _mm512_setr4_ps(matrix[3], matrix[7], matrix[11], matrix[15]);
+        // Products with explicit rounding cannot be contracted into fused multiply-adds, which would round differently
+        constexpr int rounding = _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC;
+        constexpr __mmask16 all = 0xffff;
+        size_t i = 0;
+        for (; i + 4 <= count; i += 4, points += 16, transformed += 16) {
+            const __m512 four = _mm512_loadu_ps(points);
+            const __m512 x = _mm512_maskz_mul_round_ps(all, column_x, _mm512_shuffle_ps(four, four, 0x00), rounding);
+            const __m512 y = _mm512_maskz_mul_round_ps(all, column_y, _mm512_shuffle_ps(four, four, 0x55), rounding);
+            const __m512 z = _mm512_maskz_mul_round_ps(all, column_z, _mm512_shuffle_ps(four, four, 0xaa), rounding);
+            const __m512 w = _mm512_maskz_mul_round_ps(all, column_w, _mm512_shuffle_ps(four, four, 0xff), rounding);
+            _mm512_storeu_ps(transformed, _mm512_add_ps(_mm512_add_ps(x, y), _mm512_add_ps(z, w)));
+        }
+        transform_avx2(matrix, points, transformed, count - i);
+    }
+#endif
+}
+
+
+SimdKernels SimdKernels::bind(const InstructionSet instruction_set) {
+    switch (instruction_set) {
+#ifdef RENDERER_X86
+        // Tile rows are 16 pixels, so AVX-512 shading would run a single iteration; the AVX2 kernel does as well
+        case InstructionSet::AVX512: return { fill_avx512, resolve_avx2, transform_avx512, shade_lights_avx2, instruction_set };
+        case InstructionSet::AVX2: return { fill_avx2, resolve_avx2, transform_avx2, shade_lights_avx2, instruction_set };
+        case InstructionSet::SSE2: return { fill_sse2, resolve_sse2, transform_sse2, shade_lights_sse2, instruction_set };
+#endif
+        default: return { fill_scalar, resolve_scalar, transform_scalar, shade_lights_scalar, InstructionSet::Scalar };
+    }
+}
+
+const SimdKernels& SimdKernels::active() {
+    static const SimdKernels kernels = bind(CpuFeatures::active());
+    return kernels;
+}
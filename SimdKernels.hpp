@@ -0,0 +1,51 @@
+#pragma once
+
+#include "CpuFeatures.hpp"
+#include "Pixel.hpp"
+
+#include <cstddef>
+#include <cstdint>
+
+
+// A point light prepared for shading: view-space position, 1 / radius squared, radius and colour
+struct ShadingLight {
+    float x, y, z;
+    float inverse_radius_squared;
+    float radius;
+    float red, green, blue;
+};
+
+// A run of pixels as structure-of-arrays, so that each light is applied across the run at once
+struct ShadingRow {
+    const float* x;
+    const float* y;
+    const float* z;
+    const float* normal_x;
+    const float* normal_y;
+    const float* normal_z;
+    float* red;
+    float* green;
+    float* blue;
+    size_t count;
+};
+
+
+// Hot loops with one implementation per instruction set, bound once to the best the host
+// supports. Every implementation returns bit-identical results, so any path can stand in
+// for another when testing
+struct SimdKernels {
+    // Fills count pixels
+    void (*fill)(Pixel* destination, size_t count, Pixel);
+    // Averages each run of sample_count (2, 4 or 8) samples into one pixel, rounding down
+    void (*resolve)(const Pixel* samples, int sample_count, size_t pixel_count, Pixel* resolved);
+    // Multiplies count homogeneous points by a row-major 4x4 matrix; points are four aligned floats
+    void (*transform)(const float* matrix, const float* points, float* transformed, size_t count);
+    // Adds the lights picked out by indices to the row's colours, with a squared falloff to zero at the radius
+    void (*shade_lights)(const ShadingRow&, const ShadingLight* lights, const uint32_t* indices, size_t index_count);
+
+    InstructionSet instruction_set;
+
+    static SimdKernels bind(InstructionSet);
+    // The kernels for CpuFeatures::active()
+    static const SimdKernels& active();
+};
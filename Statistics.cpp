@@ -0,0 +1,91 @@
+#include "Statistics.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <utility>
+
+
+namespace {
+    std::atomic<uint64_t> next_collector_id = 1;
+    thread_local Statistics::Collector* current_collector = nullptr;
+    // This thread's accumulators in the collectors it counted into most recently, so a pool thread
+    // that serves several contexts in turn finds each without locking. Ids are never reused
+    struct CachedAccumulator {
+        uint64_t collector_id = 0;
+        FrameStatistics* accumulator = nullptr;
+    };
+    thread_local std::array<CachedAccumulator, 4> cached_accumulators;
+    thread_local size_t next_cached_accumulator = 0;
+}
+
+
+const char* stage_name(const Stage stage) {
+    switch (stage) {
+        case Stage::Events: return "Events";
+        case Stage::Scene: return "Scene";
+        case Stage::Shadow: return "Shadow";
+        case Stage::Geometry: return "Geometry";
+        case Stage::Sort: return "Sort";
+        case Stage::Raster: return "Raster";
+        case Stage::Shading: return "Shading";
+        case Stage::Resolve: return "Resolve";
+        case Stage::Present: return "Present";
+        default: return "Unknown";
+    }
+}
+
+FrameStatistics& FrameStatistics::operator+=(const FrameStatistics& other) {
+    triangles_submitted += other.triangles_submitted;
+    triangles_back_face_culled += other.triangles_back_face_culled;
+    triangles_frustum_culled += other.triangles_frustum_culled;
+    triangles_clipped += other.triangles_clipped;
+    triangles_rasterised += other.triangles_rasterised;
+    pixels_written += other.pixels_written;
+    for (size_t i = 0; i < stage_times.size(); ++i) {
+        stage_times[i] += other.stage_times[i];
+    }
+    return *this;
+}
+
+Statistics::Collector::Collector() : _id(next_collector_id.fetch_add(1, std::memory_order_relaxed)) {}
+
+FrameStatistics Statistics::Collector::collect() {
+    std::lock_guard lock(_mutex);
+    FrameStatistics total;
+    for (auto& accumulator : _accumulators) {
+        total += accumulator.statistics;
+        accumulator.statistics = {};
+    }
+    return total;
+}
+
+Statistics::Collector* Statistics::set_current(Collector* collector) {
+    return std::exchange(current_collector, collector);
+}
+
+FrameStatistics& Statistics::local() {
+    static Collector process_wide;
+    Collector& collector = current_collector != nullptr ? *current_collector : process_wide;
+    for (const auto& cached : cached_accumulators) {
+        if (cached.collector_id == collector._id) {
+            return *cached.accumulator;
+        }
+    }
+
+    // Evicted from the cache, or new to this collector; either way the collector keeps one accumulator per thread
+    FrameStatistics* accumulator = nullptr;
+    {
+        std::lock_guard lock(collector._mutex);
+        const auto thread = std::this_thread::get_id();
+        const auto existing = std::ranges::find(collector._accumulators, thread, &Collector::Accumulator::thread);
+        accumulator = existing != collector._accumulators.end() ? &existing->statistics : &collector._accumulators.emplace_back(thread).statistics;
+    }
+    cached_accumulators[next_cached_accumulator] = { collector._id, accumulator };
+    next_cached_accumulator = (next_cached_accumulator + 1) % cached_accumulators.size();
+    return *accumulator;
+}
+
+Statistics::ScopedTimer::~ScopedTimer() {
+    const auto elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - _start).count();
+    local().stage_times[static_cast<size_t>(_stage)] += elapsed;
+}
@@ -0,0 +1,92 @@
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <thread>
+
+
+enum class Stage : uint8_t {
+    Events,
+    Scene,
+    Shadow,
+    Geometry,
+    Sort,
+    Raster,
+    Shading,
+    Resolve,
+    Present,
+    Count
+};
+
+const char* stage_name(Stage);
+
+
+struct FrameStatistics {
+    uint64_t triangles_submitted = 0;
+    uint64_t triangles_back_face_culled = 0;
+    uint64_t triangles_frustum_culled = 0;
+    uint64_t triangles_clipped = 0;
+    uint64_t triangles_rasterised = 0;
+    uint64_t pixels_written = 0;
+    double overdraw = 0;   // Pixels written per screen pixel
+    double frame_time = 0;
+    double render_time = 0;   // Wall time from update to resolve; stage times add up across threads, so can exceed it
+    std::array<double, static_cast<size_t>(Stage::Count)> stage_times{};
+
+    FrameStatistics& operator+=(const FrameStatistics&);
+};
+
+
+// Every thread counts into its own accumulator, so hot loops never contend or synchronise.
+// Accumulators belong to the collector current on their thread, or to a process-wide one, so
+// render contexts on different threads keep their counts apart. collect() folds a collector's
+// accumulators together once per frame, while no stage is running
+namespace Statistics {
+    class Collector {
+    public:
+        Collector();
+        Collector(const Collector&) = delete;
+        Collector& operator=(const Collector&) = delete;
+        FrameStatistics collect();
+    private:
+        friend FrameStatistics& local();
+        struct Accumulator {
+            std::thread::id thread;
+            FrameStatistics statistics;
+        };
+        const uint64_t _id;
+        std::mutex _mutex;
+        // One per thread that has counted here. A deque keeps accumulators in place as threads join
+        std::deque<Accumulator> _accumulators;
+    };
+
+    // Makes a collector, or none, current on the calling thread and returns the one it replaces.
+    // A collector must outlive every thread it is current on
+    Collector* set_current(Collector*);
+    FrameStatistics& local();
+
+    // Keeps a collector current on the calling thread for the scope's lifetime
+    class CollectorScope {
+    public:
+        explicit CollectorScope(Collector& collector) : _previous(set_current(&collector)) {}
+        ~CollectorScope() { set_current(_previous); }
+        CollectorScope(const CollectorScope&) = delete;
+        CollectorScope& operator=(const CollectorScope&) = delete;
+    private:
+        Collector* _previous;
+    };
+
+    class ScopedTimer {
+    public:
+        explicit ScopedTimer(Stage stage) : _stage(stage), _start(std::chrono::steady_clock::now()) {}
+        ~ScopedTimer();
+        ScopedTimer(const ScopedTimer&) = delete;
+        ScopedTimer& operator=(const ScopedTimer&) = delete;
+    private:
+        Stage _stage;
+        std::chrono::steady_clock::time_point _start;
+    };
+}
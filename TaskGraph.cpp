@@ -0,0 +1,57 @@
+#include "TaskGraph.hpp"
+
+#include <stdexcept>
+#include <string>
+
+
+TaskGraph::Task TaskGraph::add(const char* name, std::function<void()> work, const std::initializer_list<Task> dependencies) {
+    return add(name, std::move(work), std::span<const Task>(dependencies.begin(), dependencies.size()));
+}
+
+TaskGraph::Task TaskGraph::add(const char* name, std::function<void()> work, const std::span<const Task> dependencies) {
+    const Task task = _nodes.size();
+    for (const Task dependency : dependencies) {
+        if (dependency >= task) {
+            throw std::runtime_error(std::string("Task ") + name + " depends on a task that has not been added");
+        }
+    }
+    Node& node = _nodes.emplace_back();
+    node.name = name;
+    node.work = std::move(work);
+    node.dependency_count = dependencies.size();
+    for (const Task dependency : dependencies) {
+        _nodes[dependency].successors.push_back(task);
+    }
+    return task;
+}
+
+void TaskGraph::run(JobSystem& jobs) {
+    for (auto& node : _nodes) {
+        node.remaining.store(node.dependency_count, std::memory_order_relaxed);
+    }
+    JobCounter counter;
+    for (Task task = 0; task < _nodes.size(); ++task) {
+        if (_nodes[task].dependency_count == 0) {
+            launch(jobs, counter, task);
+        }
+    }
+    jobs.wait(counter);
+}
+
+void TaskGraph::clear() {
+    _nodes.clear();
+}
+
+void TaskGraph::launch(JobSystem& jobs, JobCounter& counter, const Task task) {
+    Node& node = _nodes[task];
+    // Successors are only released once the work is done; on failure they never run and the counter
+    // still drains, because the failed task is the last thing outstanding on its branch
+    jobs.submit(node.name, [this, &jobs, &counter, &node] {
+        node.work();
+        for (const Task successor : node.successors) {
+            if (_nodes[successor].remaining.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+                launch(jobs, counter, successor);
+            }
+        }
+    }, &counter);
+}
@@ -0,0 +1,42 @@
+#pragma once
+
+#include "JobSystem.hpp"
+
+#include <atomic>
+#include <deque>
+#include <functional>
+#include <initializer_list>
+#include <span>
+#include <vector>
+
+
+// A set of named jobs with explicit dependencies, run on a JobSystem. A task starts as soon as every
+// task it depends on has finished, so independent branches overlap instead of meeting at stage barriers
+class TaskGraph {
+public:
+    using Task = size_t;
+
+    // Dependencies must already have been added, which also rules out cycles. name must outlive the graph's run
+    Task add(const char* name, std::function<void()> work, std::initializer_list<Task> dependencies = {});
+    Task add(const char* name, std::function<void()> work, std::span<const Task> dependencies);
+
+    // Runs every task and returns once all have finished, rethrowing the first exception any threw.
+    // A graph can be run again
+    void run(JobSystem&);
+    void clear();
+
+    size_t size() const { return _nodes.size(); }
+private:
+    struct Node {
+        const char* name;
+        std::function<void()> work;
+        std::vector<Task> successors;
+        size_t dependency_count = 0;
+        std::atomic<size_t> remaining = 0;
+    };
+
+    void launch(JobSystem&, JobCounter&, Task);
+
+    // A deque keeps nodes, with their atomics, in place as the graph grows
+    std::deque<Node> _nodes;
+};
@@ -0,0 +1,156 @@
+#include "TiledLighting.hpp"
+
+#include "SimdKernels.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+
+
+namespace {
+    constexpr int tile_size = 16;
+
+    // View-space direction through a screen position, scaled so that its z is 1
+    Vector3D view_ray(const TiledLightingInput& input, const double x, const double y) {
+        const auto& minimum = input.viewport_minimum;
+        const auto& maximum = input.viewport_maximum;
+        const double x_ndc = 2 * (x - minimum.x) / (maximum.x - minimum.x) - 1;
+        const double y_ndc = 2 * (y - minimum.y) / (maximum.y - minimum.y) - 1;
+        return Vector3D(static_cast<Scalar>(-x_ndc / input.x_scale), static_cast<Scalar>(-y_ndc / input.y_scale), 1);
+    }
+
+    // tile_lights is scratch space, kept between tiles so that it only grows
+    void shade_tile(const GBuffer& g_buffer, const TiledLightingInput& input, std::span<const ShadingLight> lights, std::vector<uint32_t>& tile_lights, const int tile_x, const int tile_y, std::span<Pixel> output) {
+        const int width = g_buffer.width();
+        const int x0 = input.viewport_minimum.x + tile_x * tile_size;
+        const int y0 = input.viewport_minimum.y + tile_y * tile_size;
+        const int x1 = std::min(x0 + tile_size, input.viewport_maximum.x);
+        const int y1 = std::min(y0 + tile_size, input.viewport_maximum.y);
+
+        float min_depth = std::numeric_limits<float>::infinity();
+        float max_depth = 0;
+        for (int y = y0; y < y1; ++y) {
+            for (int x = x0; x < x1; ++x) {
+                const float depth = g_buffer.depth(static_cast<size_t>(y) * width + x);
+                if (std::isfinite(depth)) {
+                    min_depth = std::min(min_depth, depth);
+                    max_depth = std::max(max_depth, depth);
+                }
+            }
+        }
+        if (min_depth > max_depth) {
+            for (int y = y0; y < y1; ++y) {
+                std::fill(output.begin() + static_cast<size_t>(y) * width + x0, output.begin() + static_cast<size_t>(y) * width + x1, Pixel{ 0, 0, 0 });
+            }
+            return;
+        }
+
+        // Side planes of the tile's frustum, through the eye and two adjacent corner rays
+        const std::array<Vector3D, 4> corners = {
+            view_ray(input, x0, y0),
+            view_ray(input, x1, y0),
+            view_ray(input, x1, y1),
+            view_ray(input, x0, y1),
+        };
+        const Vector3D centre = view_ray(input, (x0 + x1) / 2.0, (y0 + y1) / 2.0);
+        std::array<Vector3D, 4> planes;
+        for (size_t i = 0; i < 4; ++i) {
+            planes[i] = cross(corners[i], corners[(i + 1) % 4]).normalised();
+            if (dot(planes[i], centre) < 0) {
+                planes[i] = -planes[i];
+            }
+        }
+
+        tile_lights.clear();
+        for (size_t i = 0; i < lights.size(); ++i) {
+            const ShadingLight& light = lights[i];
+            if (light.z + light.radius < min_depth or light.z - light.radius > max_depth) {
+                continue;
+            }
+            const Vector3D position(light.x, light.y, light.z);
+            if (std::ranges::all_of(planes, [&](const Vector3D& plane) { return dot(plane, position) >= -light.radius; })) {
+                tile_lights.push_back(static_cast<uint32_t>(i));
+            }
+        }
+
+        const Vector3D& sun = input.directional_light.direction;
+        const Vector3D& sun_colour = input.directional_light.colour;
+
+        // Structure-of-arrays for one tile row, so every light is applied across the row at once
+        std::array<float, tile_size> px{}, py{}, pz{}, nx{}, ny{}, nz{}, red{}, green{}, blue{};
+        const ShadingRow shading_row = { px.data(), py.data(), pz.data(), nx.data(), ny.data(), nz.data(), red.data(), green.data(), blue.data(), tile_size };
+        const auto shade_lights = SimdKernels::active().shade_lights;
+        for (int y = y0; y < y1; ++y) {
+            const int count = x1 - x0;
+            const size_t row = static_cast<size_t>(y) * width + x0;
+
+            for (int i = 0; i < count; ++i) {
+                const float depth = g_buffer.depth(row + i);
+                const float depth_or_zero = std::isfinite(depth) ? depth : 0;
+                const Vector3D ray = view_ray(input, x0 + i + 0.5, y + 0.5);
+                const Vector3D normal = g_buffer.normal(row + i);
+                px[i] = static_cast<float>(ray.x * depth_or_zero);
+                py[i] = static_cast<float>(ray.y * depth_or_zero);
+                pz[i] = depth_or_zero;
+                nx[i] = static_cast<float>(normal.x);
+                ny[i] = static_cast<float>(normal.y);
+                nz[i] = static_cast<float>(normal.z);
+                float sun_intensity = std::max(0.0f, static_cast<float>(nx[i] * sun.x + ny[i] * sun.y + nz[i] * sun.z));
+                if (input.shadow_map != nullptr and sun_intensity > 0 and std::isfinite(depth)) {
+                    sun_intensity *= static_cast<float>(input.shadow_map->visibility(input.view_to_shadow * Vector3D(px[i], py[i], pz[i])));
+                }
+                red[i] = sun_intensity * static_cast<float>(sun_colour.x);
+                green[i] = sun_intensity * static_cast<float>(sun_colour.y);
+                blue[i] = sun_intensity * static_cast<float>(sun_colour.z);
+            }
+
+            shade_lights(shading_row, lights.data(), tile_lights.data(), tile_lights.size());
+
+            for (int i = 0; i < count; ++i) {
+                if (not std::isfinite(g_buffer.depth(row + i))) {
+                    output[row + i] = { 0, 0, 0 };
+                    continue;
+                }
+                const Pixel& albedo = g_buffer.albedo(row + i);
+                output[row + i] = {
+                    static_cast<uint8_t>(std::min(albedo.red * red[i], 255.0f)),
+                    static_cast<uint8_t>(std::min(albedo.green * green[i], 255.0f)),
+                    static_cast<uint8_t>(std::min(albedo.blue * blue[i], 255.0f)),
+                };
+            }
+        }
+    }
+}
+
+
+void shade_tiled(JobSystem& jobs, const GBuffer& g_buffer, const TiledLightingInput& input, const std::span<Pixel> output) {
+    if (output.size() != static_cast<size_t>(g_buffer.width()) * g_buffer.height()) {
+        throw std::runtime_error("Output size does not match the G-buffer");
+    }
+    const auto& minimum = input.viewport_minimum;
+    const auto& maximum = input.viewport_maximum;
+    if (minimum.x < 0 or minimum.y < 0 or maximum.x > g_buffer.width() or maximum.y > g_buffer.height() or minimum.x >= maximum.x or minimum.y >= maximum.y) {
+        throw std::runtime_error("Viewport does not fit the G-buffer");
+    }
+
+    std::vector<ShadingLight> lights;
+    lights.reserve(input.point_lights.size());
+    for (const auto& light : input.point_lights) {
+        lights.push_back({
+            static_cast<float>(light.position.x), static_cast<float>(light.position.y), static_cast<float>(light.position.z),
+            static_cast<float>(1 / (light.radius * light.radius)),
+            static_cast<float>(light.radius),
+            static_cast<float>(light.colour.x), static_cast<float>(light.colour.y), static_cast<float>(light.colour.z)
+        });
+    }
+
+    const int tiles_x = (maximum.x - minimum.x + tile_size - 1) / tile_size;
+    const int tiles_y = (maximum.y - minimum.y + tile_size - 1) / tile_size;
+    jobs.parallel_for("Shade tiles", static_cast<size_t>(tiles_x) * tiles_y, 4, [&](const size_t begin, const size_t end) {
+        std::vector<uint32_t> tile_lights;
+        for (size_t tile = begin; tile < end; ++tile) {
+            shade_tile(g_buffer, input, lights, tile_lights, static_cast<int>(tile % tiles_x), static_cast<int>(tile / tiles_x), output);
+        }
+    });
+}
@@ -0,0 +1,31 @@
+#pragma once
+
+#include "GBuffer.hpp"
+#include "JobSystem.hpp"
+#include "Light.hpp"
+#include "ShadowMap.hpp"
+
+#include <span>
+#include <vector>
+
+
+// Lights are given in view space; x_scale and y_scale are the projection matrix's
+// diagonal terms, used to rebuild each pixel's view-space position from its depth.
+// When a shadow map is given, view_to_shadow maps view space into its light clip space.
+// Only the viewport, the pixels from viewport_minimum up to but not including viewport_maximum,
+// is shaded, and the projection is taken to cover exactly that
+struct TiledLightingInput {
+    double x_scale;
+    double y_scale;
+    DirectionalLight directional_light;
+    std::span<const PointLight> point_lights;
+    const ShadowMap* shadow_map = nullptr;
+    Matrix4x4 view_to_shadow = make_identity_matrix();
+    Coordinate viewport_minimum;
+    Coordinate viewport_maximum;
+};
+
+
+// Culls the point lights against screen tiles, then shades each tile with only the lights
+// touching it. Tiles are shaded as jobs; pixels within a tile row are shaded together
+void shade_tiled(JobSystem&, const GBuffer&, const TiledLightingInput&, std::span<Pixel> output);
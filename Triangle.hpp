@@ -7,25 +7,28 @@
 #include <array>
 
 
-struct Triangle {
-    std::array<Vector3D, 3> vertices;
-    double illumination = 0;
-
-    Triangle() = default;
-    Triangle(std::array<Vector3D, 3> vertices) : vertices(vertices) {}
-    Triangle(std::initializer_list<Vector3D> vertices) {
+template <typename T>
+struct BasicTriangle {
+    std::array<BasicVector3D<T>, 3> vertices;
+    T illumination = 0;
+
+    BasicTriangle() = default;
+    BasicTriangle(std::array<BasicVector3D<T>, 3> vertices) : vertices(vertices) {}
+    BasicTriangle(std::initializer_list<BasicVector3D<T>> vertices) {
         size_t i = 0;
         for (auto& vertex : vertices) {
             this->vertices[i++] = vertex;
         }
     }
 
-    Vector3D normal() const { return cross(vertices[1] - vertices[0], vertices[2] - vertices[0]).normalise(); }
-    double depth() const { return (vertices[0].z + vertices[1].z + vertices[2].z) / 3; }
+    BasicVector3D<T> normal() const { return cross(vertices[1] - vertices[0], vertices[2] - vertices[0]).normalise(); }
+    T depth() const { return (vertices[0].z + vertices[1].z + vertices[2].z) / 3; }
 
-    void transform(const Matrix4x4& matrix) {
+    void transform(const BasicMatrix4x4<T>& matrix) {
         for (auto& vertex : vertices) {
             vertex *= matrix;
         }
     }
-};
\ No newline at end of file
+};
+
+using Triangle = BasicTriangle<Scalar>;
@@ -1,44 +1,71 @@
 #pragma once
 
+#include "Scalar.hpp"
+
 #include <array>
+#include <cmath>
+#include <type_traits>
 #include <vector>
 
 
-struct Vector3D {
-    double x, y, z, w;
+template <typename T>
+struct alignas(16) BasicVector3D {
+    T x, y, z, w;
 
-    Vector3D(const double x = 0, const double y = 0, const double z = 0, const double w = 1) : x(x), y(y), z(z), w(w) {}
-    Vector3D(const std::initializer_list<double>& list) : x(*list.begin()), y(*(list.begin() + 1)), z(*(list.begin() + 2)), w(*(list.begin() + 3)) {}
-    Vector3D(const std::vector<double>& vector) : x(vector[0]), y(vector[1]), z(vector[2]), w(1) { if (vector.size() == 4) w = vector[3]; }
-    Vector3D(const std::array<double, 3>& array) : x(array[0]), y(array[1]), z(array[2]), w(1) {}
-    Vector3D(const std::array<double, 4>& array) : x(array[0]), y(array[1]), z(array[2]), w(array[3]) {}
-    Vector3D(const Vector3D&) = default;
+    BasicVector3D(const T x = 0, const T y = 0, const T z = 0, const T w = 1) : x(x), y(y), z(z), w(w) {}
+    BasicVector3D(const std::initializer_list<T>& list) : x(*list.begin()), y(*(list.begin() + 1)), z(*(list.begin() + 2)), w(list.size() > 3 ? *(list.begin() + 3) : 1) {}
+    BasicVector3D(const std::vector<T>& vector) : x(vector[0]), y(vector[1]), z(vector[2]), w(1) { if (vector.size() == 4) w = vector[3]; }
+    BasicVector3D(const std::array<T, 3>& array) : x(array[0]), y(array[1]), z(array[2]), w(1) {}
+    BasicVector3D(const std::array<T, 4>& array) : x(array[0]), y(array[1]), z(array[2]), w(array[3]) {}
+    BasicVector3D(const BasicVector3D&) = default;
+    template <typename U>
+    explicit BasicVector3D(const BasicVector3D<U>& other) : x(static_cast<T>(other.x)), y(static_cast<T>(other.y)), z(static_cast<T>(other.z)), w(static_cast<T>(other.w)) {}
 
-    Vector3D& operator=(const Vector3D&) = default;
-    Vector3D operator-() const { return { -x, -y, -z, -w }; }
+    BasicVector3D& operator=(const BasicVector3D&) = default;
+    bool operator==(const BasicVector3D&) const = default;
+    BasicVector3D operator-() const { return { -x, -y, -z, -w }; }
 
-    double magnitude() const;
-    Vector3D& normalise();
-    Vector3D normalised() const;
+    T magnitude() const;
+    BasicVector3D& normalise();
+    BasicVector3D normalised() const;
 
-    Vector3D& operator+=(const Vector3D& other);
-    Vector3D& operator-=(const Vector3D& other);
+    BasicVector3D& operator+=(const BasicVector3D& other);
+    BasicVector3D& operator-=(const BasicVector3D& other);
 
-    Vector3D& operator*=(double scalar);
-    Vector3D& operator/=(double scalar);
+    BasicVector3D& operator*=(std::type_identity_t<T> scalar);
+    BasicVector3D& operator/=(std::type_identity_t<T> scalar);
 
-    Vector3D& operator++() { return *this += { 1, 1, 1 }; }
-    Vector3D& operator--() { return *this -= { 1, 1, 1 }; }
+    BasicVector3D& operator++() { return *this += { 1, 1, 1 }; }
+    BasicVector3D& operator--() { return *this -= { 1, 1, 1 }; }
 
-    Vector3D operator++(int) { const Vector3D temp = *this; ++*this; return temp; }
-    Vector3D operator--(int) { const Vector3D temp = *this; --*this; return temp; }
+    BasicVector3D operator++(int) { const BasicVector3D temp = *this; ++*this; return temp; }
+    BasicVector3D operator--(int) { const BasicVector3D temp = *this; --*this; return temp; }
 };
 
+using Vector3D = BasicVector3D<Scalar>;
+
+
+#ifdef RENDERER_SSE
+inline __m128 load(const BasicVector3D<float>& vector) { return _mm_load_ps(&vector.x); }
+inline BasicVector3D<float> store(const __m128 value) {
+    BasicVector3D<float> result;
+    _mm_store_ps(&result.x, value);
+    return result;
+}
+// Arithmetic yields points, so w is replaced with 1
+inline __m128 with_unit_w(const __m128 value) {
+    const __m128 xyz = _mm_castsi128_ps(_mm_set_epi32(0, -1, -1, -1));
+    return _mm_or_ps(_mm_and_ps(value, xyz), _mm_set_ps(1, 0, 0, 0));
+}
+#endif
+
 
-inline double dot(const Vector3D& lhs, const Vector3D& rhs) {
+template <typename T>
+inline T dot(const BasicVector3D<T>& lhs, const BasicVector3D<T>& rhs) {
     return lhs.x * rhs.x + lhs.y * rhs.y + lhs.z * rhs.z;
 }
-inline Vector3D cross(const Vector3D& lhs, const Vector3D& rhs) {
+template <typename T>
+inline BasicVector3D<T> cross(const BasicVector3D<T>& lhs, const BasicVector3D<T>& rhs) {
     return {
         lhs.y * rhs.z - lhs.z * rhs.y,
         lhs.z * rhs.x - lhs.x * rhs.z,
@@ -46,20 +73,60 @@ inline Vector3D cross(const Vector3D& lhs, const Vector3D& rhs) {
     };
 }
 
-inline double Vector3D::magnitude() const { return sqrt(dot(*this, *this)); }
-
-inline Vector3D operator+(const Vector3D& lhs, const Vector3D& rhs) { return { lhs.x + rhs.x, lhs.y + rhs.y, lhs.z + rhs.z }; }
-inline Vector3D operator-(const Vector3D& lhs, const Vector3D& rhs) { return { lhs.x - rhs.x, lhs.y - rhs.y, lhs.z - rhs.z }; }
-
-inline Vector3D& Vector3D::operator+=(const Vector3D& other) { return *this = *this + other; }
-inline Vector3D& Vector3D::operator-=(const Vector3D& other) { return *this = *this - other; }
+template <typename T>
+inline T BasicVector3D<T>::magnitude() const { return std::sqrt(dot(*this, *this)); }
+
+template <typename T>
+inline BasicVector3D<T> operator+(const BasicVector3D<T>& lhs, const BasicVector3D<T>& rhs) {
+#ifdef RENDERER_SSE
+    if constexpr (std::is_same_v<T, float>) {
+        return store(with_unit_w(_mm_add_ps(load(lhs), load(rhs))));
+    }
+#endif
+    return { lhs.x + rhs.x, lhs.y + rhs.y, lhs.z + rhs.z };
+}
+template <typename T>
+inline BasicVector3D<T> operator-(const BasicVector3D<T>& lhs, const BasicVector3D<T>& rhs) {
+#ifdef RENDERER_SSE
+    if constexpr (std::is_same_v<T, float>) {
+        return store(with_unit_w(_mm_sub_ps(load(lhs), load(rhs))));
+    }
+#endif
+    return { lhs.x - rhs.x, lhs.y - rhs.y, lhs.z - rhs.z };
+}
 
-inline Vector3D operator*(const Vector3D& vector, const double scalar) { return { vector.x * scalar, vector.y * scalar, vector.z * scalar }; }
-inline Vector3D operator*(const double scalar, const Vector3D& vector) { return vector * scalar; }
-inline Vector3D operator/(const Vector3D& vector, const double scalar) { return { vector.x / scalar, vector.y / scalar, vector.z / scalar }; }
+template <typename T>
+inline BasicVector3D<T>& BasicVector3D<T>::operator+=(const BasicVector3D& other) { return *this = *this + other; }
+template <typename T>
+inline BasicVector3D<T>& BasicVector3D<T>::operator-=(const BasicVector3D& other) { return *this = *this - other; }
+
+template <typename T>
+inline BasicVector3D<T> operator*(const BasicVector3D<T>& vector, const std::type_identity_t<T> scalar) {
+#ifdef RENDERER_SSE
+    if constexpr (std::is_same_v<T, float>) {
+        return store(with_unit_w(_mm_mul_ps(load(vector), _mm_set1_ps(scalar))));
+    }
+#endif
+    return { vector.x * scalar, vector.y * scalar, vector.z * scalar };
+}
+template <typename T>
+inline BasicVector3D<T> operator*(const std::type_identity_t<T> scalar, const BasicVector3D<T>& vector) { return vector * scalar; }
+template <typename T>
+inline BasicVector3D<T> operator/(const BasicVector3D<T>& vector, const std::type_identity_t<T> scalar) {
+#ifdef RENDERER_SSE
+    if constexpr (std::is_same_v<T, float>) {
+        return store(with_unit_w(_mm_div_ps(load(vector), _mm_set1_ps(scalar))));
+    }
+#endif
+    return { vector.x / scalar, vector.y / scalar, vector.z / scalar };
+}
 
-inline Vector3D& Vector3D::operator*=(const double scalar) { return *this = *this * scalar; }
-inline Vector3D& Vector3D::operator/=(const double scalar) { return *this = *this / scalar; }
+template <typename T>
+inline BasicVector3D<T>& BasicVector3D<T>::operator*=(const std::type_identity_t<T> scalar) { return *this = *this * scalar; }
+template <typename T>
+inline BasicVector3D<T>& BasicVector3D<T>::operator/=(const std::type_identity_t<T> scalar) { return *this = *this / scalar; }
 
-inline Vector3D& Vector3D::normalise() { return *this /= magnitude(); }
-inline Vector3D Vector3D::normalised() const { return *this / magnitude(); }
\ No newline at end of file
+template <typename T>
+inline BasicVector3D<T>& BasicVector3D<T>::normalise() { return *this /= magnitude(); }
+template <typename T>
+inline BasicVector3D<T> BasicVector3D<T>::normalised() const { return *this / magnitude(); }
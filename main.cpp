@@ -1,14 +1,110 @@
 #include <iostream>
+#include <string>
 
 #include "Engine3D.hpp"
 
-int main(int, char**) {
+int main(int argument_count, char** arguments) {
     try {
-        Engine3D engine(600, 480);
+        auto display = Renderer::Display::Window;
+        std::string record_path;
+        auto record_format = FrameWriter::Format::PPMSequence;
+        std::string export_name;
+        int frame_rate = 30;
+        int frame_limit = 0;
+        bool turntable = false;
+        double target_frame_time = 0;
+        std::string mesh_path;
+        MeshLoadOptions mesh_options;
+        JobSystem::Options job_options;
+        std::string trace_path;
+        bool inset = false;
+        bool reprojection = false;
+
+        for (int i = 1; i < argument_count; ++i) {
+            const std::string argument = arguments[i];
+            const auto value = [&]() -> std::string {
+                if (i + 1 >= argument_count) {
+                    throw std::runtime_error("Missing value for " + argument);
+                }
+                return arguments[++i];
+            };
+            if (argument == "--headless") {
+                display = Renderer::Display::Headless;
+            } else if (argument == "--record") {
+                record_path = value();
+            } else if (argument == "--format") {
+                const std::string format = value();
+                if (format == "ppm") {
+                    record_format = FrameWriter::Format::PPMSequence;
+                } else if (format == "y4m") {
+                    record_format = FrameWriter::Format::Y4M;
+                } else if (format == "raw") {
+                    record_format = FrameWriter::Format::Raw;
+                } else {
+                    throw std::runtime_error("Unknown format " + format + " (expected ppm, y4m or raw)");
+                }
+            } else if (argument == "--export") {
+                export_name = value();
+            } else if (argument == "--fps") {
+                frame_rate = std::stoi(value());
+            } else if (argument == "--frames") {
+                frame_limit = std::stoi(value());
+            } else if (argument == "--target-frame-time") {
+                target_frame_time = std::stod(value()) / 1000;
+            } else if (argument == "--mesh") {
+                mesh_path = value();
+            } else if (argument == "--optimise") {
+                mesh_options.optimise = true;
+            } else if (argument == "--quantise") {
+                mesh_options.quantise = true;
+            } else if (argument == "--workers") {
+                job_options.worker_count = static_cast<unsigned>(std::stoul(value()));
+            } else if (argument == "--pin-threads") {
+                job_options.pin_threads = true;
+            } else if (argument == "--trace") {
+                trace_path = value();
+            } else if (argument == "--inset") {
+                inset = true;
+            } else if (argument == "--reproject") {
+                reprojection = true;
+            } else if (argument == "--turntable") {
+                turntable = true;
+            } else {
+                throw std::runtime_error("Unknown argument " + argument);
+            }
+        }
+        if (display == Renderer::Display::Headless and frame_limit <= 0) {
+            throw std::runtime_error("--headless needs --frames");
+        }
+
+        Engine3D engine(600, 480, "Software Renderer", display);
+        engine.configure_jobs(job_options);
+        if (not trace_path.empty()) {
+            engine.trace(trace_path);
+        }
+        if (not mesh_path.empty() or mesh_options.optimise or mesh_options.quantise) {
+            engine.set_mesh(mesh_path.empty() ? "meshes/teapot.obj" : mesh_path, mesh_options);
+        }
+        if (not record_path.empty()) {
+            engine.record(record_path, record_format, frame_rate);
+        }
+        if (not export_name.empty()) {
+            engine.export_frames(export_name);
+        }
+        engine.set_frame_limit(frame_limit);
+        engine.set_auto_rotate(turntable);
+        if (inset) {
+            // An overview from above and behind the scene, in the top right corner
+            engine.add_view({ { 0, 10, 5 }, Vector3D(0, -1, 1).normalised(), 60, { 0.65, 0.05, 0.3, 0.3 } });
+        }
+        engine.set_reprojection(reprojection);
+        if (target_frame_time > 0) {
+            engine.set_dynamic_resolution(target_frame_time);
+        }
         engine.run();
     } catch (const std::exception& exception) {
         std::cerr << exception.what() << std::endl;
         return EXIT_FAILURE;
     }
     return EXIT_SUCCESS;
-}
\ No newline at end of file
+}
@@ -0,0 +1,261 @@
+// Microbenchmarks for the core primitives. Each benchmark is calibrated to run for about a tenth of a
+// second, then timed over several rounds, and the fastest round is reported as nanoseconds per operation
+// with its throughput in pixels, triangles or operations per second.
+//
+//     renderer-benchmarks [--quick] [FILTER]
+//
+// FILTER runs only the benchmarks whose names contain it. --quick times a single short round, just to
+// check that everything still runs.
+
+#include "SimdKernels.hpp"
+#include "TestSupport.hpp"
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <limits>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+
+namespace {
+    constexpr int frame_width = 640;
+    constexpr int frame_height = 480;
+
+    double round_seconds = 0.1;
+    int rounds = 5;
+    std::string filter;
+
+    // Stops the compiler from discarding a result it can see is unused
+    template <typename T>
+    void keep(const T& value) {
+#if defined(__GNUC__)
+        asm volatile("" : : "g"(&value) : "memory");
+#else
+        static volatile const void* sink;
+        sink = &value;
+#endif
+    }
+
+    std::string rate(const double per_second, const std::string& unit) {
+        constexpr std::pair<double, const char*> prefixes[] = { { 1e9, "G" }, { 1e6, "M" }, { 1e3, "k" }, { 1, "" } };
+        for (const auto& [scale, prefix] : prefixes) {
+            if (per_second >= scale or scale == 1) {
+                char text[64];
+                std::snprintf(text, sizeof(text), "%8.2f %s%s/s", per_second / scale, prefix, unit.c_str());
+                return text;
+            }
+        }
+        return {};
+    }
+
+    // body performs operations operations per call, each worth items of unit
+    template <typename Function>
+    void benchmark(const std::string& name, const size_t operations, const double items, const std::string& unit, Function&& body) {
+        if (not filter.empty() and name.find(filter) == std::string::npos) {
+            return;
+        }
+        using Clock = std::chrono::steady_clock;
+        const auto time = [&](const size_t calls) {
+            const auto start = Clock::now();
+            for (size_t call = 0; call < calls; ++call) {
+                body();
+            }
+            return std::chrono::duration<double>(Clock::now() - start).count();
+        };
+
+        size_t calls = 1;
+        while (time(calls) < round_seconds / 4 and calls < (size_t(1) << 40)) {
+            calls *= 2;
+        }
+        double best = std::numeric_limits<double>::infinity();
+        for (int round = 0; round < rounds; ++round) {
+            best = std::min(best, time(calls));
+        }
+        const double seconds_per_operation = best / static_cast<double>(calls * operations);
+        std::printf("%-40s %12.1f ns/op %s\n", name.c_str(), seconds_per_operation * 1e9, rate(items / seconds_per_operation, unit).c_str());
+    }
+
+    // Exposes the protected drawing calls
+    class Canvas final : public Renderer {
+    public:
+        Canvas() : Renderer(frame_width, frame_height, "Benchmarks", Display::Headless) {}
+        using Renderer::clear;
+        using Renderer::draw_line;
+        using Renderer::draw_filled_triangle;
+        using Renderer::pack_frame;
+    };
+
+    std::vector<Vector3D> random_vectors(std::mt19937& random, const size_t count) {
+        std::uniform_real_distribution<Scalar> coordinate(-10, 10);
+        std::vector<Vector3D> vectors(count);
+        for (auto& vector : vectors) {
+            vector = { coordinate(random), coordinate(random), coordinate(random) };
+        }
+        return vectors;
+    }
+
+    void benchmark_math(std::mt19937& random) {
+        constexpr size_t count = 1024;
+        const auto a = random_vectors(random, count);
+        const auto b = random_vectors(random, count);
+        std::vector<Vector3D> results(count);
+        const Matrix4x4 transform = make_translation_matrix(1, 2, 3) * make_rotation_matrix(0.3f, 0.7f, 1.1f);
+        const Matrix4x4 projection = make_projection_matrix({ frame_width, frame_height }, 90, 0.1f, 1000);
+
+        benchmark("Vector3D add", count, 1, "op", [&] {
+            for (size_t i = 0; i < count; ++i) {
+                results[i] = a[i] + b[i];
+            }
+            keep(results);
+        });
+        benchmark("Vector3D dot", count, 1, "op", [&] {
+            Scalar sum = 0;
+            for (size_t i = 0; i < count; ++i) {
+                sum += dot(a[i], b[i]);
+            }
+            keep(sum);
+        });
+        benchmark("Vector3D cross", count, 1, "op", [&] {
+            for (size_t i = 0; i < count; ++i) {
+                results[i] = cross(a[i], b[i]);
+            }
+            keep(results);
+        });
+        benchmark("Vector3D normalised", count, 1, "op", [&] {
+            for (size_t i = 0; i < count; ++i) {
+                results[i] = a[i].normalised();
+            }
+            keep(results);
+        });
+        benchmark("Matrix4x4 * Matrix4x4", 1, 1, "op", [&] {
+            Matrix4x4 product = projection * transform;
+            keep(product);
+        });
+        benchmark("Matrix4x4 * Vector3D", count, 1, "op", [&] {
+            for (size_t i = 0; i < count; ++i) {
+                results[i] = transform * a[i];
+            }
+            keep(results);
+        });
+        benchmark("transform_points", count, 1, "point", [&] {
+            transform_points<Scalar>(transform, a, results);
+            keep(results);
+        });
+    }
+
+    void benchmark_raster(std::mt19937& random) {
+        Canvas canvas;
+        std::uniform_int_distribution<int> x(0, frame_width - 1);
+        std::uniform_int_distribution<int> y(0, frame_height - 1);
+
+        benchmark("clear", 1, static_cast<double>(frame_width) * frame_height, "px", [&] {
+            canvas.clear({ 10, 20, 30 });
+        });
+
+        constexpr size_t line_count = 256;
+        std::vector<std::pair<Coordinate, Coordinate>> lines(line_count);
+        double line_pixels = 0;
+        for (auto& [start, end] : lines) {
+            start = { x(random), y(random) };
+            end = { x(random), y(random) };
+            line_pixels += std::max(std::abs(end.x - start.x), std::abs(end.y - start.y)) + 1;
+        }
+        benchmark("draw_line", line_count, line_pixels / line_count, "px", [&] {
+            for (const auto& [start, end] : lines) {
+                canvas.draw_line(start, end);
+            }
+        });
+
+        // Large triangles measure fill rate, small ones the fixed cost of setting a triangle up
+        const auto make_triangles = [&](const int size, const size_t count) {
+            std::uniform_int_distribution<int> offset(-size, size);
+            std::vector<std::array<Coordinate, 3>> triangles(count);
+            double area = 0;
+            for (auto& triangle : triangles) {
+                const Coordinate corner = { x(random), y(random) };
+                // Kept inside the frame, so the area counted is the area drawn
+                const auto near_corner = [&] {
+                    return Coordinate{ std::clamp(corner.x + offset(random), 0, frame_width - 1), std::clamp(corner.y + offset(random), 0, frame_height - 1) };
+                };
+                triangle = { { corner, near_corner(), near_corner() } };
+                const Coordinate ab = triangle[1] - triangle[0];
+                const Coordinate ac = triangle[2] - triangle[0];
+                area += std::abs(ab.x * ac.y - ab.y * ac.x) / 2.0;
+            }
+            return std::pair(triangles, area / static_cast<double>(count));
+        };
+        const auto [large, large_area] = make_triangles(200, 64);
+        const auto small = make_triangles(6, 4096).first;
+        for (const int samples : { 1, 4 }) {
+            canvas.set_sample_count(samples);
+            const std::string suffix = samples == 1 ? "" : " x" + std::to_string(samples);
+            benchmark("draw_filled_triangle large" + suffix, large.size(), large_area, "px", [&] {
+                for (const auto& triangle : large) {
+                    canvas.draw_filled_triangle(triangle);
+                }
+            });
+            benchmark("draw_filled_triangle small" + suffix, small.size(), 1, "tri", [&] {
+                for (const auto& triangle : small) {
+                    canvas.draw_filled_triangle(triangle);
+                }
+            });
+        }
+        canvas.set_sample_count(1);
+
+        std::vector<uint32_t> screen(static_cast<size_t>(frame_width) * frame_height);
+        benchmark("render conversion", 1, static_cast<double>(frame_width) * frame_height, "px", [&] {
+            canvas.pack_frame(screen);
+            keep(screen);
+        });
+        std::vector<Pixel> frame(static_cast<size_t>(frame_width) * frame_height);
+        benchmark("capture", 1, static_cast<double>(frame_width) * frame_height, "px", [&] {
+            canvas.capture(frame);
+            keep(frame);
+        });
+    }
+
+    void benchmark_parsing() {
+        const TestSupport::TemporaryFile file(".obj");
+        constexpr int rings = 128;
+        constexpr int segments = 64;
+        TestSupport::write_torus(file.path(), rings, segments, 2.5, 1);
+        const size_t triangles = 2 * rings * segments;
+        benchmark("OBJ parse (" + std::to_string(triangles) + " triangles)", 1, static_cast<double>(triangles), "tri", [&] {
+            const Mesh mesh(file.path().string());
+            keep(mesh.triangles);
+        });
+    }
+}
+
+
+int main(int argument_count, char** arguments) {
+    try {
+        for (int i = 1; i < argument_count; ++i) {
+            const std::string argument = arguments[i];
+            if (argument == "--quick") {
+                round_seconds = 0.004;
+                rounds = 1;
+            } else {
+                filter = argument;
+            }
+        }
+
+        std::cout << "Kernels " << instruction_set_name(SimdKernels::active().instruction_set) << "\n";
+        std::cout << "Frame " << frame_width << "x" << frame_height << "\n";
+        std::mt19937 random(1);
+        benchmark_math(random);
+        benchmark_raster(random);
+        benchmark_parsing();
+    } catch (const std::exception& exception) {
+        std::cerr << exception.what() << std::endl;
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
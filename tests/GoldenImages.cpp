@@ -0,0 +1,201 @@
+// Renders reference scenes headlessly and compares each with its image in the golden directory,
+// channel by channel within a tolerance. CTest runs this once per RENDERER_ISA setting, so every
+// kernel path has to reproduce the same images, and each 3D scene is drawn on one thread and on four.
+//
+//     golden-images GOLDEN_DIRECTORY [--update]
+//
+// --update writes the rendered images over the golden ones instead of comparing.
+
+#include "TestSupport.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <functional>
+#include <iostream>
+#include <numbers>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+
+namespace {
+    constexpr int frame_width = 160;
+    constexpr int frame_height = 120;
+
+    // A pixel passes if no channel is further than this from the golden image
+    constexpr int channel_tolerance = 2;
+    // Triangle edges can move by a pixel between compilers whose maths libraries round differently
+    constexpr double outlier_fraction = 0.002;
+
+    // Exercises the 2D primitives directly
+    class PrimitiveScene final : public Renderer {
+    public:
+        explicit PrimitiveScene(const int sample_count) : Renderer(frame_width, frame_height, "Golden", Display::Headless) {
+            set_sample_count(sample_count);
+        }
+
+        void update(double) override {
+            clear({ 20, 24, 48 });
+            // A fan of lines through every octant
+            const Coordinate centre = { 40, 60 };
+            for (int step = 0; step < 24; ++step) {
+                const double angle = 2 * std::numbers::pi * step / 24;
+                const Coordinate end = { centre.x + static_cast<int>(std::lround(36 * std::cos(angle))), centre.y + static_cast<int>(std::lround(36 * std::sin(angle))) };
+                draw_line(centre, end, { static_cast<uint8_t>(step * 10), 200, static_cast<uint8_t>(255 - step * 10) });
+            }
+            draw_filled_triangle({ { { 90, 10 }, { 150, 40 }, { 100, 70 } } }, { 220, 80, 60 });
+            // A sliver, and one that runs off the frame
+            draw_filled_triangle({ { { 85, 110 }, { 155, 100 }, { 86, 112 } } }, { 250, 230, 90 });
+            draw_filled_triangle({ { { 130, 60 }, { 200, 90 }, { 120, 140 } } }, { 70, 160, 230 });
+            draw_triangle({ { { 95, 75 }, { 125, 95 }, { 80, 98 } } }, { 255, 255, 255 });
+            draw_rectangle({ 4, 4 }, { 76, 116 }, { 120, 120, 120 });
+
+            const std::vector<RasterTriangle> batch = {
+                { { { { 100, 20 }, { 140, 20 }, { 120, 55 } } }, { 60, 200, 90 } },
+                { { { { 110, 30 }, { 150, 35 }, { 125, 65 } } }, { 200, 60, 200 } }
+            };
+            draw_triangles(batch, PipelineState::Fill::SolidWithEdges, { 0, 0, 0 });
+        }
+    };
+
+    RenderedImage render_primitives(const int sample_count) {
+        PrimitiveScene scene(sample_count);
+        scene.set_frame_limit(1);
+        scene.run();
+        RenderedImage image = { frame_width, frame_height, std::vector<Pixel>(static_cast<size_t>(frame_width) * frame_height) };
+        scene.capture(image.pixels);
+        return image;
+    }
+
+    // As BatchRenderer::render_now, but on a chosen number of threads
+    RenderedImage render_scene(const RenderRequest& request, const unsigned worker_count) {
+        Engine3D context(request.width, request.height, "Golden", Renderer::Display::Headless);
+        JobSystem::Options jobs;
+        jobs.worker_count = worker_count;
+        context.configure_jobs(jobs);
+        context.set_sample_count(request.sample_count);
+        context.set_drawing_mode(request.drawing_mode);
+        context.set_camera(request.camera_position, request.camera_direction, request.field_of_view);
+        context.set_mesh(MeshLoader::load_now(request.mesh, request.mesh_options));
+        context.set_frame_limit(1);
+        context.run();
+        RenderedImage image = { context.width(), context.height(), std::vector<Pixel>(static_cast<size_t>(context.width()) * context.height()) };
+        context.capture(image.pixels);
+        return image;
+    }
+
+    struct Scene {
+        std::string name;
+        // Variants of a scene share one golden image
+        std::string golden;
+        std::function<RenderedImage()> render;
+    };
+
+    std::vector<Scene> make_scenes(const std::string& mesh) {
+        const auto request = [&](const Engine3D::DrawingMode drawing_mode, const int sample_count, const bool quantise = false) {
+            RenderRequest request;
+            request.mesh = mesh;
+            request.mesh_options.quantise = quantise;
+            request.width = frame_width;
+            request.height = frame_height;
+            request.camera_position = { 0, 4, 8 };
+            request.camera_direction = Vector3D(0, -0.5f, 1).normalised();
+            request.field_of_view = 70;
+            request.drawing_mode = drawing_mode;
+            request.sample_count = sample_count;
+            return request;
+        };
+        const std::vector<std::pair<std::string, RenderRequest>> requests = {
+            { "wireframe", request(Engine3D::DrawingMode::WireFrame, 1) },
+            { "filled", request(Engine3D::DrawingMode::Filled, 1) },
+            { "filled_msaa4", request(Engine3D::DrawingMode::Filled, 4) },
+            { "filled_with_edges", request(Engine3D::DrawingMode::Both, 1) },
+            { "deferred", request(Engine3D::DrawingMode::Deferred, 1) },
+            { "deferred_msaa8", request(Engine3D::DrawingMode::Deferred, 8) },
+            { "quantised", request(Engine3D::DrawingMode::Filled, 2, true) }
+        };
+
+        std::vector<Scene> scenes = {
+            { "primitives", "primitives", [] { return render_primitives(1); } },
+            { "primitives_msaa4", "primitives_msaa4", [] { return render_primitives(4); } }
+        };
+        for (const auto& [name, scene_request] : requests) {
+            scenes.push_back({ name, name, [scene_request] { return render_scene(scene_request, 0); } });
+            scenes.push_back({ name + " on 4 threads", name, [scene_request] { return render_scene(scene_request, 3); } });
+        }
+        return scenes;
+    }
+
+    // Returns the failure, if any
+    std::optional<std::string> compare(const RenderedImage& image, const RenderedImage& golden) {
+        if (image.width != golden.width or image.height != golden.height) {
+            return "size " + std::to_string(image.width) + "x" + std::to_string(image.height) + " instead of " + std::to_string(golden.width) + "x" + std::to_string(golden.height);
+        }
+        int largest = 0;
+        size_t outliers = 0;
+        for (size_t i = 0; i < image.pixels.size(); ++i) {
+            const Pixel& a = image.pixels[i];
+            const Pixel& b = golden.pixels[i];
+            const int difference = std::max({ std::abs(a.red - b.red), std::abs(a.green - b.green), std::abs(a.blue - b.blue) });
+            largest = std::max(largest, difference);
+            outliers += difference > channel_tolerance;
+        }
+        const auto allowed = static_cast<size_t>(outlier_fraction * static_cast<double>(image.pixels.size()));
+        if (outliers > allowed) {
+            return std::to_string(outliers) + " pixels off by more than " + std::to_string(channel_tolerance) + " (at most " + std::to_string(allowed) + " allowed), largest difference " + std::to_string(largest);
+        }
+        return std::nullopt;
+    }
+}
+
+
+int main(int argument_count, char** arguments) {
+    try {
+        if (argument_count < 2) {
+            throw std::runtime_error("Usage: golden-images GOLDEN_DIRECTORY [--update]");
+        }
+        const std::filesystem::path directory = arguments[1];
+        const bool update = argument_count > 2 and std::string(arguments[2]) == "--update";
+
+        const TestSupport::TemporaryFile mesh(".obj");
+        TestSupport::write_torus(mesh.path(), 24, 12, 2.5, 1);
+
+        int failures = 0;
+        for (const auto& scene : make_scenes(mesh.path().string())) {
+            const auto golden_path = directory / (scene.golden + ".ppm");
+            const RenderedImage image = scene.render();
+            if (update) {
+                if (scene.name == scene.golden) {
+                    TestSupport::write_ppm(golden_path, image);
+                    std::cout << "Wrote " << golden_path.string() << '\n';
+                }
+                continue;
+            }
+
+            std::optional<std::string> failure;
+            try {
+                failure = compare(image, TestSupport::read_ppm(golden_path));
+            } catch (const std::exception& exception) {
+                failure = exception.what();
+            }
+            if (failure) {
+                ++failures;
+                const std::string actual_path = scene.golden + (scene.name == scene.golden ? "" : "_threaded") + ".actual.ppm";
+                TestSupport::write_ppm(actual_path, image);
+                std::cout << "FAIL " << scene.name << ": " << *failure << " (see " << actual_path << ")\n";
+            } else {
+                std::cout << "ok   " << scene.name << '\n';
+            }
+        }
+        if (failures > 0) {
+            std::cout << failures << " scenes differ from the golden images\n";
+            return EXIT_FAILURE;
+        }
+    } catch (const std::exception& exception) {
+        std::cerr << exception.what() << std::endl;
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
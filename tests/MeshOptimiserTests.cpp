@@ -0,0 +1,84 @@
+// Checks the mesh optimiser's cache model against hand-counted FIFO misses, and that optimising
+// a mesh reorders its triangles without losing or bending any.
+//
+//     mesh-optimiser-tests
+
+#include "MeshOptimiser.hpp"
+#include "TestSupport.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <numeric>
+#include <string>
+#include <tuple>
+#include <vector>
+
+
+namespace {
+    int failures = 0;
+
+    void check(const bool passed, const std::string& name) {
+        std::cout << (passed ? "ok   " : "FAIL ") << name << '\n';
+        failures += not passed;
+    }
+
+    void check_near(const double value, const double expected, const std::string& name) {
+        check(std::abs(value - expected) < 1e-9, name + " (" + std::to_string(value) + ", expected " + std::to_string(expected) + ")");
+    }
+
+    void test_cache_miss_ratio() {
+        // A triangle drawn twice through a three-entry cache misses only the first time
+        const std::vector<uint32_t> repeated = { 0, 1, 2, 0, 1, 2 };
+        check_near(MeshOptimiser::average_cache_miss_ratio(repeated, 3, 3), 3.0 / 2, "repeated triangle, cache of 3");
+
+        // Sixteen loads fill the default cache, so vertices 0 and 1 still hit in the sixth triangle;
+        // the seventh loads 16 and 17, which pushes 0 out before it is used again
+        std::vector<uint32_t> indices(15);
+        std::iota(indices.begin(), indices.end(), 0u);
+        indices.insert(indices.end(), { 15, 0, 1 });
+        check_near(MeshOptimiser::average_cache_miss_ratio(indices, 18), 16.0 / 6, "sixteen vertices, default cache");
+        indices.insert(indices.end(), { 16, 17, 0 });
+        check_near(MeshOptimiser::average_cache_miss_ratio(indices, 18), 19.0 / 7, "seventeenth load evicts the first");
+    }
+
+    void test_optimise() {
+        const TestSupport::TemporaryFile file(".obj");
+        TestSupport::write_torus(file.path(), 32, 16, 2.5, 1);
+        const Mesh original(file.path().string());
+        Mesh mesh(file.path().string());
+        const auto report = MeshOptimiser::optimise(mesh);
+
+        check(report.acmr_after < report.acmr_before, "optimising lowers the ACMR (" + std::to_string(report.acmr_before) + " -> " + std::to_string(report.acmr_after) + ")");
+        check_near(report.acmr_after, MeshOptimiser::average_cache_miss_ratio(mesh.indices, mesh.vertices.size()), "the report matches the optimised indices");
+
+        // Every triangle survives, with its winding, although it may start from another corner
+        const auto canonical = [](const Mesh& from) {
+            std::vector<std::array<Scalar, 9>> triangles;
+            for (const auto& triangle : from.triangles) {
+                std::array<Vector3D, 3> corners = triangle.vertices;
+                const auto first = std::ranges::min_element(corners, [](const Vector3D& a, const Vector3D& b) {
+                    return std::tie(a.x, a.y, a.z) < std::tie(b.x, b.y, b.z);
+                });
+                std::ranges::rotate(corners, first);
+                triangles.push_back({ corners[0].x, corners[0].y, corners[0].z, corners[1].x, corners[1].y, corners[1].z, corners[2].x, corners[2].y, corners[2].z });
+            }
+            std::ranges::sort(triangles);
+            return triangles;
+        };
+        check(canonical(mesh) == canonical(original), "optimising keeps every triangle");
+    }
+}
+
+
+int main() {
+    test_cache_miss_ratio();
+    test_optimise();
+    if (failures > 0) {
+        std::cout << failures << " checks failed\n";
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,94 @@
+#include "TestSupport.hpp"
+
+#include <cmath>
+#include <fstream>
+#include <numbers>
+#include <random>
+#include <stdexcept>
+#include <vector>
+
+
+void TestSupport::write_ppm(const std::filesystem::path& path, const RenderedImage& image) {
+    std::ofstream file(path, std::ios::binary);
+    if (not file) {
+        throw std::runtime_error("Could not open file " + path.string());
+    }
+    std::vector<char> bytes(image.pixels.size() * 3);
+    for (size_t i = 0; i < image.pixels.size(); ++i) {
+        bytes[i * 3 + 0] = static_cast<char>(image.pixels[i].red);
+        bytes[i * 3 + 1] = static_cast<char>(image.pixels[i].green);
+        bytes[i * 3 + 2] = static_cast<char>(image.pixels[i].blue);
+    }
+    file << "P6\n" << image.width << ' ' << image.height << "\n255\n";
+    file.write(bytes.data(), static_cast<std::streamsize>(bytes.size()));
+}
+
+RenderedImage TestSupport::read_ppm(const std::filesystem::path& path) {
+    std::ifstream file(path, std::ios::binary);
+    if (not file) {
+        throw std::runtime_error("Could not open file " + path.string());
+    }
+    std::string magic;
+    int maximum = 0;
+    RenderedImage image;
+    file >> magic >> image.width >> image.height >> maximum;
+    if (magic != "P6" or image.width <= 0 or image.height <= 0 or maximum != 255) {
+        throw std::runtime_error(path.string() + " is not an 8-bit binary PPM");
+    }
+    file.get();
+
+    std::vector<char> bytes(static_cast<size_t>(image.width) * image.height * 3);
+    if (not file.read(bytes.data(), static_cast<std::streamsize>(bytes.size()))) {
+        throw std::runtime_error(path.string() + " is truncated");
+    }
+    image.pixels.resize(static_cast<size_t>(image.width) * image.height);
+    for (size_t i = 0; i < image.pixels.size(); ++i) {
+        image.pixels[i] = {
+            static_cast<uint8_t>(bytes[i * 3 + 0]),
+            static_cast<uint8_t>(bytes[i * 3 + 1]),
+            static_cast<uint8_t>(bytes[i * 3 + 2])
+        };
+    }
+    return image;
+}
+
+void TestSupport::write_torus(const std::filesystem::path& path, const int rings, const int segments, const double major_radius, const double minor_radius) {
+    std::ofstream file(path);
+    if (not file) {
+        throw std::runtime_error("Could not open file " + path.string());
+    }
+    file << "# Torus, " << rings << " rings of " << segments << " segments\n";
+    for (int ring = 0; ring < rings; ++ring) {
+        const double around = 2 * std::numbers::pi * ring / rings;
+        for (int segment = 0; segment < segments; ++segment) {
+            const double across = 2 * std::numbers::pi * segment / segments;
+            const double distance = major_radius + minor_radius * std::cos(across);
+            file << "v " << distance * std::cos(around) << ' ' << minor_radius * std::sin(across) << ' ' << distance * std::sin(around) << '\n';
+        }
+    }
+    const auto index = [&](const int ring, const int segment) {
+        return (ring % rings) * segments + segment % segments + 1;
+    };
+    for (int ring = 0; ring < rings; ++ring) {
+        for (int segment = 0; segment < segments; ++segment) {
+            const int a = index(ring, segment);
+            const int b = index(ring + 1, segment);
+            const int c = index(ring + 1, segment + 1);
+            const int d = index(ring, segment + 1);
+            file << "f " << a << ' ' << d << ' ' << c << '\n';
+            file << "f " << a << ' ' << c << ' ' << b << '\n';
+        }
+    }
+}
+
+
+TestSupport::TemporaryFile::TemporaryFile(const std::string& extension) {
+    // Random, so that tests running side by side never share a file
+    std::random_device random;
+    _path = std::filesystem::temp_directory_path() / ("renderer-" + std::to_string(random()) + "-" + std::to_string(random()) + extension);
+}
+
+TestSupport::TemporaryFile::~TemporaryFile() {
+    std::error_code error;
+    std::filesystem::remove(_path, error);
+}
@@ -0,0 +1,30 @@
+#pragma once
+
+#include "BatchRenderer.hpp"
+
+#include <filesystem>
+#include <string>
+
+
+// Shared by the benchmarks and the golden-image tests
+namespace TestSupport {
+    // Binary PPM; alpha is dropped on writing and read back as opaque
+    void write_ppm(const std::filesystem::path&, const RenderedImage&);
+    RenderedImage read_ppm(const std::filesystem::path&);
+
+    // A torus around the y axis as an OBJ, wound so faces point outwards, with 2 * rings * segments triangles
+    void write_torus(const std::filesystem::path&, int rings, int segments, double major_radius, double minor_radius);
+
+    // A file in the temporary directory that is deleted again with the object
+    class TemporaryFile {
+    public:
+        explicit TemporaryFile(const std::string& extension);
+        ~TemporaryFile();
+        TemporaryFile(const TemporaryFile&) = delete;
+        TemporaryFile& operator=(const TemporaryFile&) = delete;
+
+        const std::filesystem::path& path() const { return _path; }
+    private:
+        std::filesystem::path _path;
+    };
+}
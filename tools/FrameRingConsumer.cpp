@@ -0,0 +1,134 @@
+// Reference consumer for Renderer::export_frames: reads frames from the shared memory ring in place and
+// reports how many arrived, how many were dropped and how old they were when read.
+//
+//     FrameRingConsumer NAME [--snapshot PATH] [--hold MILLISECONDS]
+//
+// --snapshot writes the last frame as a binary PPM. --hold keeps every frame that long before releasing
+// it, standing in for a slow encoder, so the producer has to drop frames.
+
+#include "../SharedFrameRing.hpp"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+
+namespace {
+    double milliseconds_since(const int64_t nanoseconds, const int64_t now) {
+        return static_cast<double>(now - nanoseconds) / 1e6;
+    }
+
+    int64_t now_nanoseconds() {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+    std::optional<SharedFrameRing::Reader> open(const std::string& name) {
+        // The renderer may not have created the ring yet
+        for (int attempt = 0; attempt < 100; ++attempt) {
+            try {
+                return std::optional<SharedFrameRing::Reader>(std::in_place, name);
+            } catch (const std::exception&) {
+                std::this_thread::sleep_for(std::chrono::milliseconds(50));
+            }
+        }
+        return std::optional<SharedFrameRing::Reader>(std::in_place, name);
+    }
+
+    void write_ppm(const std::string& path, const uint32_t width, const uint32_t height, const std::vector<Pixel>& pixels) {
+        std::FILE* const file = std::fopen(path.c_str(), "wb");
+        if (file == nullptr) {
+            throw std::runtime_error("Could not open file " + path);
+        }
+        std::vector<uint8_t> row(width * 3);
+        std::fprintf(file, "P6\n%u %u\n255\n", width, height);
+        for (uint32_t y = 0; y < height; ++y) {
+            for (uint32_t x = 0; x < width; ++x) {
+                const Pixel& pixel = pixels[static_cast<size_t>(y) * width + x];
+                row[x * 3 + 0] = pixel.red;
+                row[x * 3 + 1] = pixel.green;
+                row[x * 3 + 2] = pixel.blue;
+            }
+            std::fwrite(row.data(), 1, row.size(), file);
+        }
+        std::fclose(file);
+    }
+}
+
+
+int main(int argument_count, char** arguments) {
+    try {
+        if (argument_count < 2) {
+            throw std::runtime_error("Usage: FrameRingConsumer NAME [--snapshot PATH] [--hold MILLISECONDS]");
+        }
+        const std::string name = arguments[1];
+        std::string snapshot_path;
+        int hold_milliseconds = 0;
+        for (int i = 2; i < argument_count; ++i) {
+            const std::string argument = arguments[i];
+            if (i + 1 >= argument_count) {
+                throw std::runtime_error("Missing value for " + argument);
+            }
+            if (argument == "--snapshot") {
+                snapshot_path = arguments[++i];
+            } else if (argument == "--hold") {
+                hold_milliseconds = std::stoi(arguments[++i]);
+            } else {
+                throw std::runtime_error("Unknown argument " + argument);
+            }
+        }
+
+        auto reader = open(name);
+        const auto& header = reader->header();
+        std::cout << name << ": " << header.width << "x" << header.height << ", " << header.slot_count << " slots" << std::endl;
+
+        uint64_t frames = 0;
+        uint64_t gaps = 0;
+        std::optional<uint64_t> last_frame_number;
+        double render_milliseconds = 0;
+        double latency_milliseconds = 0;
+        std::vector<Pixel> snapshot;
+        while (not reader->finished()) {
+            const auto frame = reader->acquire();
+            if (not frame) {
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+                continue;
+            }
+            const int64_t now = now_nanoseconds();
+            const auto& slot = frame->slot;
+            if (last_frame_number and slot.frame_number != *last_frame_number + 1) {
+                gaps += slot.frame_number - *last_frame_number - 1;
+            }
+            last_frame_number = slot.frame_number;
+            ++frames;
+            render_milliseconds += static_cast<double>(slot.published - slot.render_start) / 1e6;
+            latency_milliseconds += milliseconds_since(slot.published, now);
+
+            if (hold_milliseconds > 0) {
+                std::this_thread::sleep_for(std::chrono::milliseconds(hold_milliseconds));
+            }
+            // Whether this is the last frame is only known once the producer closes, so keep each one
+            if (not snapshot_path.empty()) {
+                snapshot.assign(frame->pixels.begin(), frame->pixels.end());
+            }
+            reader->release();
+        }
+        if (not snapshot.empty()) {
+            write_ppm(snapshot_path, header.width, header.height, snapshot);
+        }
+
+        std::cout << frames << " frames read, " << gaps << " missing, " << header.dropped.load() << " dropped by the producer" << std::endl;
+        if (frames > 0) {
+            std::cout << "Mean render to publish " << render_milliseconds / frames << "ms, publish to read " << latency_milliseconds / frames << "ms" << std::endl;
+        }
+    } catch (const std::exception& exception) {
+        std::cerr << exception.what() << std::endl;
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}